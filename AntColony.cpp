@@ -1,369 +1,806 @@
-/*
- * Copyright (c) 2024 Ch Oy @ NWPU
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#include "AntColony.h"
-#include <float.h>
-#include <math.h>
-#include <stdlib.h>
-#include <iostream>
-
-AntColony::AntColony(GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end)
-    : map(map), antCount(antCount), maxIterations(maxIterations), start(start), end(end) {
-    initializePheromones();
-}
-
-void AntColony::initializePheromones() {
-    pheromones = std::vector<std::vector<double>>(map.getWidth(), std::vector<double>(map.getHeight(), 1.0));
-}
-
-void AntColony::initializeAnts() {
-    ants.clear();
-    for (int i = 0; i < antCount; ++i) {
-        ants.emplace_back(start);
-    }
-}
-
-void AntColony::evaluateAndUpdateBestPath(Ant& ant) {
-    int currentPathLength = calculatePathLength(ant.path);
-    ant.pathLength = currentPathLength;
-    if (currentPathLength < bestPathLength) {
-        bestPathLength = currentPathLength;
-        bestPath = ant.path;
-    }
-}
-
-void AntColony::moveAnts() {
-    for (auto& ant : ants) {
-        if ((ant.currentPosition == end) && (!ant.arrived)) {
-            ant.arrived = true;
-            // Ϣس
-            for (auto& ant : ants) {
-                for (auto& node : ant.path) {
-                    // ɵϢ
-                    pheromones[node.first][node.second] += Q / ant.pathLength;
-
-                    ////ɵϢ
-                    //double pheromoneCandidate = Q / ant.pathLength;
-                    ///*double pheromoneCandidate = Q / pow(ant.pathLength, 2);*/
-                    //if (pheromoneCandidate > pheromones[node.first][node.second])
-                    //    pheromones[node.first][node.second] = pheromoneCandidate;
-                }
-            }
-            evaluateAndUpdateBestPath(ant);
-            
-            //󷵻һ
-            //ant.path.clear(); // յǰ·
-            //ant.path.emplace_back(start);
-            //ant.currentPosition = start; // 
-        }
-        if (!ant.arrived) {
-            auto nextNodes = getFeasibleNextNodes(ant);
-            if (!nextNodes.empty()) {
-                int nextNodeIndex = chooseNextNode(ant);
-                ant.currentPosition = nextNodes[nextNodeIndex];
-                ant.path.push_back(ant.currentPosition);
-                ant.pathLength = calculatePathLength(ant.path);
-            }
-        }
-    }
-    //printAntsDistribution();
-}
-
-void AntColony::printAntsDistribution() const {
-    // դ洢ϵ
-    std::vector<std::vector<int>> antsDistribution(map.getHeight(), std::vector<int>(map.getWidth(), 0));
-
-    // ÿе
-    for (const auto& ant : ants) {
-        int x = ant.currentPosition.first;
-        int y = ant.currentPosition.second;
-        antsDistribution[y][x]++; 
-    }
-
-    //ͼ
-    for (int y = 0; y < map.getHeight(); ++y) {
-        for (int x = 0; x < map.getWidth(); ++x) {
-            if (map.isObstacle(x, y)) {
-                std::cout << "X"; // ʹXʾϰ
-            }
-            else if (antsDistribution[y][x] > 0) {
-                std::cout << antsDistribution[y][x]; // ӡϵ
-            }
-            else {
-                std::cout << " "; // ʹõʾհ
-            }
-        }
-        std::cout << std::endl;
-    }
-}
-
-int AntColony::chooseNextNode(const Ant& ant) {
-    auto nextNodes = getFeasibleNextNodes(ant);
-    std::vector<double> probabilities(nextNodes.size(), 0.0);
-    double probabilitySum = 0.0;
-
-    for (size_t i = 0; i < nextNodes.size(); ++i) {
-        auto node = nextNodes[i];
-        double pheromone = pow(pheromones[node.first][node.second], alpha);
-        // ԾĵΪʽϢ
-        double heuristic = 1.0 / sqrt(pow(node.first - end.first, 2) + pow(node.second - end.second, 2)); // ֱ߾
-        //int heuristic = abs(node.first - end.first) + abs(node.second - end.second); // դ Ŀһ
-        double probability = pheromone * pow(heuristic, beta);
-        probabilities[i] = probability;
-        probabilitySum += probability;
-    }
-
-    // ̶ѡһڵ
-    double randomValue = (double)rand() / RAND_MAX * probabilitySum;
-    double cumulativeProbability = 0.0;
-    for (size_t i = 0; i < probabilities.size(); ++i) {
-        cumulativeProbability += probabilities[i];
-        if (randomValue <= cumulativeProbability) {
-            return i;
-        }
-    }
-    return 0; // ĬϷصһڵΪ
-}
-
-std::vector<std::pair<int, int>> AntColony::getFeasibleNextNodes(const Ant& ant) const {
-    std::pair<int, int> position = ant.currentPosition;
-    std::vector<std::pair<int, int>> nextNodes;
-    const std::vector<std::pair<int, int>> directions = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} }; //    
-
-    for (auto& dir : directions) {
-        std::pair<int, int> nextPosition = { position.first + dir.first, position.second + dir.second };
-        if (nextPosition.first >= 0 && nextPosition.first < map.getWidth() &&
-            nextPosition.second >= 0 && nextPosition.second < map.getHeight() &&
-            !map.isObstacle(nextPosition.first, nextPosition.second)) {
-            if (ant.path.size() == 1) {
-                nextNodes.push_back(nextPosition);
-            }else {
-                if (nextPosition != ant.path[ant.path.size() - 2]) //ֹ߻ͷ·
-                    nextNodes.push_back(nextPosition);
-            }
-        }
-    }
-    return nextNodes;
-}
-
-void AntColony::updatePheromones() {
-    // Ϣ
-    for (auto& row : pheromones) {
-        for (auto& pheromone : row) {
-            pheromone *= (1.0 - evaporationRate);
-        }
-    }
-
-    //// Ϣس
-    //for (auto& ant : ants) {
-    //    if (ant.arrived) {
-    //        for (auto& node : ant.path) {
-    //            //pheromones[node.first][node.second] += Q / pow(ant.pathLength, 2);// ɵϢ
-    //            
-    //            //ɵϢ
-    //            double pheromoneCandidate = Q / ant.pathLength;
-    //            /*double pheromoneCandidate = Q / pow(ant.pathLength, 2);*/
-    //            if (pheromoneCandidate > pheromones[node.first][node.second])
-    //                pheromones[node.first][node.second] = pheromoneCandidate;
-    //        }
-    //    }
-
-    //}
-
-    //// Ϣس
-    //for (auto& ant : ants) {
-    //    for (auto& node : ant.path) {
-    //        pheromones[node.first][node.second] += Q / pow(ant.pathLength, 2);
-    //    }
-    //}
-}
-
-void AntColony::run() {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_CURSOR_INFO cursorInfo;
-    GetConsoleCursorInfo(hConsole, &cursorInfo);
-    cursorInfo.bVisible = false; // ù겻ɼ
-    SetConsoleCursorInfo(hConsole, &cursorInfo);
-    int maxSteps = getMaxSteps();
-    std::ofstream BPLfile("BestPathLength.csv");
-    std::ofstream APLfile("AveragePathLength.csv");
-    for (int iteration = 0; iteration < maxIterations; ++iteration) {
-        progressBar(iteration, maxIterations, "Iteration", 50, 0);
-        initializeAnts();
-        for (int step = 0; step < maxSteps; ++step) {
-            progressBar(step, maxSteps, "Step     ", 50, 1);;
-            moveAnts();
-        }
-        /*for (auto& ant : ants) {
-            evaluateAndUpdateBestPath(ant);
-        }*/
-        updatePheromones();
-        std::cout << std::endl << "Iteration:" << iteration << std::endl;
-        printPheromones();
-        savePheromoneMatrixToCSV(pheromones, iteration);
-        BPLfile << bestPathLength << "\n";
-        int sumArrivedPathLength= 0;
-        int antArrivedCount = 0;
-        for (auto& ant : ants) {
-            if (ant.arrived) {
-                sumArrivedPathLength += ant.pathLength;
-                antArrivedCount++;
-            }  
-        }
-        double averagePathLength = sumArrivedPathLength / (double)antArrivedCount;
-        APLfile << averagePathLength << "\n";
-    }
-    //printBestPath();
-}
-
-int AntColony::getMaxSteps() const { 
-    int deltaX = abs(start.first - end.first);
-    int deltaY = abs(start.second - end.second);
-    return (deltaX + deltaY) * 6;
-    //return (deltaX + 2) * (deltaY + 2);
-}
-
-int AntColony::calculatePathLength(const std::vector<std::pair<int, int>>& path) const {
-    double length = 0;
-    length = path.size() - 1;
-    return length;
-}
-
-void AntColony::printBestPath() const {
-    if (bestPath.empty()) {
-        std::cout << "No path found." << std::endl;
-        return;
-    }
-
-    std::cout << "Best path length: " << bestPathLength << std::endl;
-    std::cout << "Best path visual representation with (0,0) at bottom left:" << std::endl;
-
-    // 
-    std::vector<std::vector<char>> grid(map.getHeight(), std::vector<char>(map.getWidth(), ' '));
-
-    // עϰ
-    for (int y = 0; y < map.getHeight(); ++y) {
-        for (int x = 0; x < map.getWidth(); ++x) {
-            if (map.isObstacle(x, y)) {
-                grid[map.getHeight() - y - 1][x] = 'X';
-            }
-        }
-    }
-
-    // ע·
-    for (const auto& node : bestPath) {
-        // Assuming y is inverted due to (0,0) being at the bottom left
-        grid[map.getHeight() - node.second - 1][node.first] = '*';
-    }
-
-    // ͼ
-    for (int y = 0; y < map.getHeight(); ++y) {
-        // ϱ߽
-        if (y == 0) {
-            for (int x = 0; x < map.getWidth(); ++x) {
-                std::cout << "+---";
-            }
-            std::cout << "+" << std::endl;
-        }
-
-        for (int x = 0; x < map.getWidth(); ++x) {
-            // ߽
-            std::cout << "| " << grid[y][x]<<" ";
-        }
-        // ұ߽
-        std::cout << "|" << std::endl;
-
-        // ±߽
-        for (int x = 0; x < map.getWidth(); ++x) {
-            std::cout << "+---";
-        }
-        std::cout << "+" << std::endl;
-    }
-}
-
-void AntColony::printPheromones() const {
-    for (int y = pheromones.size() - 1; y >= 0; --y) {
-        // ϱ߽
-        if (y == pheromones.size() - 1) {
-            std::cout << "+";
-            for (int x = 0; x < pheromones[y].size(); ++x) {
-                std::cout << "---+";
-            }
-            std::cout << std::endl;
-        }
-
-        // Ϣֵұ߽
-        for (int x = 0; x < pheromones[y].size(); ++x) {
-            if (x == 0) std::cout << "|";
-            // ʾϢֵ֣ÿռַĿȣ999ʾ999
-            if (pheromones[x][y] < 999)
-                std::cout << std::setw(3) << std::setfill(' ') << static_cast<int>(pheromones[x][y]) << "|";
-            else
-                std::cout << std::setw(3) << std::setfill(' ') << 999 << "|";
-        }
-        std::cout << std::endl;
-
-        // ±߽
-        std::cout << "+";
-        for (int x = 0; x < pheromones[y].size(); ++x) {
-            std::cout << "---+";
-        }
-        std::cout << std::endl;
-    }
-}
-
-void AntColony::setCursorPosition(int x, int y) {
-    static const HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-    std::cout.flush();
-    COORD coord = { (SHORT)x, (SHORT)y };
-    SetConsoleCursorPosition(hOut, coord);
-}
-
-void AntColony::progressBar(int current, int total, const std::string& prefix, int barWidth, int posY) {
-    float progress = (float)current / total;
-    int pos = static_cast<int>(barWidth * progress);
-
-    setCursorPosition(0, posY);
-    std::cout << prefix << " [";
-
-    for (int i = 0; i < barWidth; ++i) {
-        if (i < pos) std::cout << "=";
-        else if (i == pos) std::cout << ">";
-        else std::cout << " ";
-    }
-
-    std::cout << "] " << current << "/" << total << "   "; // ոԸǾɵı
-}
-
-void AntColony::savePheromoneMatrixToCSV(const std::vector<std::vector<double>>& pheromones, int iteration) {
-    std::string filename = "pheromones_" + std::to_string(iteration) + ".csv";
-    std::ofstream file(filename);
-
-    for (int y = 0; y < pheromones.size(); ++y) {
-        for (int x = 0; x < pheromones[y].size(); ++x) {
-            file << pheromones[y][x];
-            if (x < pheromones[y].size() - 1) file << ",";
-        }
-        file << "\n";
-    }
-    file.close();
-}
-
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "AntColony.h"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <stdexcept>
+
+AntColonyBase::AntColonyBase(const GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end)
+    : map(map), start(start), end(end), startCell(map.cellId(start.first, start.second)),
+      endCell(map.cellId(end.first, end.second)), antCount(antCount), maxIterations(maxIterations) {
+    initializePheromones();
+    mapListener = map.addChangeListener([this](const std::vector<int>& cells) { onMapChanged(cells); });
+}
+
+AntColonyBase::~AntColonyBase() {
+    map.removeChangeListener(mapListener);
+}
+
+void AntColonyBase::initializePheromones() {
+    pheromones.assign(map.getWidth(), map.getHeight(), 1.0);
+}
+
+// A bidirectional colony splits its ants between the two directions; forward
+// paths get room for the backward trail they may join.
+void AntColonyBase::initializeAnts() {
+    if (!constructionSettings.bidirectional) {
+        ants.reset(antCount, startCell, getMaxSteps());
+        return;
+    }
+    backwardAnts.reset(antCount / 2, endCell, getMaxSteps());
+    ants.reset(antCount - antCount / 2, startCell, 2 * getMaxSteps());
+}
+
+AntColonyBase::Walk AntColonyBase::forwardWalk() {
+    Walk walk = { &ants, startCell, endCell, heuristicTable->data(), constructionSettings.bidirectional ? &trailMarks : nullptr,
+                  corridors.get(), getMaxSteps() + 1 };
+    return walk;
+}
+
+AntColonyBase::Walk AntColonyBase::backwardWalk() {
+    Walk walk = { &backwardAnts, endCell, startCell, backwardHeuristicTable.data(), nullptr, corridors.get(), getMaxSteps() + 1 };
+    return walk;
+}
+
+// Every cell a backward ant reached leads back to end along its path; of several
+// trails through a cell the one with the fewest steps from end wins, ties to the
+// lower ant. start stays unmarked, or forward ants would arrive without moving.
+void AntColonyBase::markTrails() {
+    trailMarks.next();
+    int stride = backwardAnts.pathStride;
+    for (int ant = 0; ant < backwardAnts.size(); ++ant) {
+        const int* path = backwardAnts.path(ant);
+        for (int i = 0; i < backwardAnts.pathSize(ant); ++i) {
+            int cell = path[i];
+            if (cell == startCell) continue;
+            if (trailMarks.marked(cell) && trailMarks.values[cell] % stride <= i) continue;
+            trailMarks.mark(cell);
+            trailMarks.values[cell] = ant * stride + i;
+        }
+    }
+}
+
+// Completes the path of a forward ant that stopped on a backward trail with the
+// trail's way back to end.
+void AntColonyBase::joinTrail(int ant) {
+    int cell = ants.positions[ant];
+    if (!trailMarks.marked(cell)) return; // reached end by itself
+    int stride = backwardAnts.pathStride;
+    const int* trail = backwardAnts.path(trailMarks.values[cell] / stride);
+    for (int i = trailMarks.values[cell] % stride - 1; i >= 0; --i) {
+        ants.extendPath(ant, trail[i]);
+    }
+    ants.positions[ant] = endCell;
+    ants.pathLengths[ant] = getPathLength(ants.path(ant), ants.pathSize(ant));
+}
+
+void AntColonyBase::setThreadCount(int count) {
+    threadCount = count < 1 ? 1 : count;
+}
+
+void AntColonyBase::setSeed(uint64_t value) {
+    seed = value;
+}
+
+void AntColonyBase::initializeWorkers() {
+    if (threadCount > 1 && (!pool || pool->getThreadCount() != threadCount)) {
+        pool.reset(new ThreadPool(threadCount));
+    }
+    else if (threadCount == 1) {
+        pool.reset();
+    }
+    generators.clear();
+    for (int worker = 0; worker < threadCount; ++worker) {
+        generators.emplace_back(seed, worker);
+    }
+    activeAnts.resize(threadCount);
+    backtrackSteps.assign(threadCount, 0);
+    candidateCounts.assign(threadCount, 0);
+}
+
+// Before every iteration, so construction settings changed between resume() calls
+// or from a callback during the run find their marks sized; a no-op otherwise.
+void AntColonyBase::prepareConstruction() {
+    if (constructionSettings.avoidVisited) {
+        visitedMarks.resize((size_t)threadCount * RandomLanes::lanes);
+        for (CellMarks& marks : visitedMarks) {
+            marks.prepare(map.getCellCount(), false);
+        }
+    }
+    else {
+        visitedMarks.clear();
+    }
+    if (constructionSettings.eraseLoops) {
+        loopMarks.prepare(map.getCellCount(), true);
+    }
+    if (constructionSettings.bidirectional) {
+        trailMarks.prepare(map.getCellCount(), true);
+        bestPath.reserve(2 * getMaxSteps() + 1); // joined paths are longer
+    }
+    if (constructionSettings.compressCorridors != (bool)corridors) {
+        if (constructionSettings.compressCorridors) buildCorridors();
+        else corridors.reset();
+    }
+}
+
+void AntColonyBase::buildCorridors() {
+    corridors.reset(new CorridorTable(map.findCorridors(getConnectivity(), { startCell, endCell })));
+}
+
+// Reduction step: arrivals are collected in ant order, so the result only depends on the seed and thread count.
+// Only the iteration's best ant is copied into bestPath, whose capacity run() reserves.
+void AntColonyBase::collectArrivedAnts() {
+    arrivedAnts.clear();
+    int bestAnt = -1;
+    long long steps = 0;
+    for (long long& count : backtrackSteps) {
+        steps += count;
+        count = 0;
+    }
+    for (long long& count : candidateCounts) {
+        ANTCOLONY_METRICS_ADD(metrics.counters[CandidatesCounter], count);
+        count = 0;
+    }
+    if (constructionSettings.bidirectional) {
+        for (int i = 0; i < backwardAnts.size(); ++i) {
+            steps += backwardAnts.pathSize(i) - 1;
+        }
+    }
+    for (int i = 0; i < ants.size(); ++i) {
+        steps += ants.pathSize(i) - 1;
+        if (!ants.arrived[i]) {
+            ANTCOLONY_METRICS_ADD(metrics.counters[ants.alive[i] ? StepBudgetAntsCounter : DeadEndAntsCounter], 1);
+            continue;
+        }
+        if (constructionSettings.bidirectional) joinTrail(i);
+        if (constructionSettings.eraseLoops) eraseLoops(ants, i);
+        if (ants.pathLengths[i] < bestPathLength) {
+            bestPathLength = ants.pathLengths[i];
+            bestAnt = i;
+        }
+        arrivedAnts.push_back(i);
+    }
+    // a backward ant that reached start without meeting a trail walked a whole
+    // path; turned around (steps cost the same both ways) it counts like any other
+    for (int i = 0; constructionSettings.bidirectional && i < backwardAnts.size(); ++i) {
+        if (!backwardAnts.arrived[i]) continue;
+        std::reverse(backwardAnts.path(i), backwardAnts.path(i) + backwardAnts.pathSize(i));
+        if (constructionSettings.eraseLoops) eraseLoops(backwardAnts, i);
+        if (backwardAnts.pathLengths[i] < bestPathLength) {
+            bestPathLength = backwardAnts.pathLengths[i];
+            bestAnt = ants.size() + i;
+        }
+        arrivedAnts.push_back(ants.size() + i);
+    }
+    antSteps += steps;
+    ANTCOLONY_METRICS_ADD(metrics.counters[AntStepsCounter], steps);
+    ANTCOLONY_METRICS_ADD(metrics.counters[ArrivedAntsCounter], (long long)arrivedAnts.size());
+    if (bestAnt >= 0) {
+        bestPath.assign(arrivedPath(bestAnt), arrivedPath(bestAnt) + arrivedPathSize(bestAnt));
+        ANTCOLONY_METRICS_ADD(metrics.counters[BestPathImprovementsCounter], 1);
+    }
+}
+
+// Chronological loop erasure: whenever the path returns to a cell, the cycle since
+// the cell's earlier visit is dropped. Linear in the path length.
+void AntColonyBase::eraseLoops(ColonyState& walkers, int ant) {
+    int* path = walkers.path(ant);
+    int size = walkers.pathSize(ant);
+    loopMarks.next();
+    int kept = 0;
+    for (int i = 0; i < size; ++i) {
+        int cell = path[i];
+        if (loopMarks.marked(cell)) {
+            int earlier = loopMarks.values[cell];
+            for (int j = earlier + 1; j < kept; ++j) {
+                loopMarks.unmark(path[j]);
+            }
+            kept = earlier + 1;
+        }
+        else {
+            loopMarks.mark(cell);
+            loopMarks.values[cell] = kept;
+            path[kept++] = cell;
+        }
+    }
+    if (kept < size) {
+        walkers.pathSizes[ant] = kept;
+        walkers.pathLengths[ant] = getPathLength(path, kept);
+    }
+}
+
+void AntColonyBase::printAntsDistribution() const {
+    // 创建栅格来存储蚂蚁的数量
+    std::vector<std::vector<int>> antsDistribution(map.getHeight(), std::vector<int>(map.getWidth(), 0));
+
+    // 计算每个方格中的蚂蚁数量
+    for (int position : ants.positions) {
+        int x = map.cellX(position);
+        int y = map.cellY(position);
+        antsDistribution[y][x]++; 
+    }
+
+    //画图
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            if (map.isObstacle(x, y)) {
+                std::cout << "X"; // 使用X表示障碍物
+            }
+            else if (antsDistribution[y][x] > 0) {
+                std::cout << antsDistribution[y][x]; // 打印蚂蚁的数量
+            }
+            else {
+                std::cout << " "; // 使用点表示空白区域
+            }
+        }
+        std::cout << std::endl;
+    }
+}
+
+void AntColonyBase::setHeuristicDistances(const std::vector<double>& distances) {
+    setHeuristicDistances(std::make_shared<const std::vector<double>>(distances));
+}
+
+void AntColonyBase::setHeuristicDistances(std::shared_ptr<const std::vector<double>> distances) {
+    if (distances && (int)distances->size() != map.getCellCount()) {
+        throw std::invalid_argument("heuristic distances do not match the map size");
+    }
+    heuristicDistances = distances;
+    distanceFields = nullptr;
+    heuristicTable.reset();
+    ownHeuristicTable.reset();
+}
+
+void AntColonyBase::setHeuristicDistances(DistanceFieldCache& cache) {
+    setHeuristicDistances(cache.get(map, endCell, getConnectivity()));
+    distanceFields = &cache;
+}
+
+void AntColonyBase::setStartHeuristicDistances(std::shared_ptr<const std::vector<double>> distances) {
+    if (distances && (int)distances->size() != map.getCellCount()) {
+        throw std::invalid_argument("heuristic distances do not match the map size");
+    }
+    startHeuristicDistances = distances;
+    backwardHeuristicTable.clear();
+}
+
+void AntColonyBase::setPheromones(const std::vector<double>& values) {
+    if ((int)values.size() != map.getCellCount()) {
+        throw std::invalid_argument("pheromone field does not match the map size");
+    }
+    pheromones.assign(values);
+}
+
+void AntColonyBase::setPheromones(const PheromoneField& field) {
+    if (field.size() != map.getCellCount()) {
+        throw std::invalid_argument("pheromone field does not match the map size");
+    }
+    pheromones = field;
+}
+
+void AntColonyBase::setPheromoneSettings(const PheromoneSettings& settings) {
+    pheromoneSettings = settings;
+}
+
+void AntColonyBase::updateMaxMinBounds() {
+    // Stuetzle & Hoos: tauMax = 1 / (rho * L_best), tauMin chosen so the best path is rebuilt with probability p_best
+    tauMax = Q / (evaporationRate * bestPathLength);
+    double root = pow(pheromoneSettings.bestProbability, 1.0 / bestPathLength);
+    tauMin = tauMax * (1.0 - root) / ((pheromoneSettings.averageBranching - 1.0) * root);
+    if (tauMin > tauMax) tauMin = tauMax;
+}
+
+void AntColonyBase::depositAlongPath(const int* path, int size, double amount) {
+    pheromones.reserveTiles(path, size);
+    for (int i = 0; i < size; ++i) {
+        pheromones.deposit(path[i], amount);
+    }
+}
+
+// 每次迭代只执行一次：先蒸发，再按所选规则沉积
+void AntColonyBase::updatePheromones(int iteration) {
+    bool maxMin = pheromoneSettings.rule == PheromoneRule::MaxMin && !bestPath.empty();
+    if (maxMin) {
+        updateMaxMinBounds();
+    }
+
+    // 信息素蒸发: only the global scale changes, and tauMin is applied when the field is read
+    {
+        ANTCOLONY_METRICS_TIMER(metrics.phaseSeconds[EvaporationPhase]);
+        pheromones.evaporate(evaporationRate);
+        pheromones.setFloor(maxMin ? tauMin : 0.0);
+    }
+
+    // 信息素沉积
+    ANTCOLONY_METRICS_TIMER(metrics.phaseSeconds[DepositPhase]);
+    switch (pheromoneSettings.rule) {
+    case PheromoneRule::AntSystem:
+        for (int index : arrivedAnts) {
+            depositAlongPath(arrivedPath(index), arrivedPathSize(index), Q / arrivedPathLength(index));
+        }
+        break;
+    case PheromoneRule::Elitist:
+        for (int index : arrivedAnts) {
+            depositAlongPath(arrivedPath(index), arrivedPathSize(index), Q / arrivedPathLength(index));
+        }
+        if (!bestPath.empty()) {
+            depositAlongPath(bestPath.data(), (int)bestPath.size(), pheromoneSettings.elitistWeight * Q / bestPathLength);
+        }
+        break;
+    case PheromoneRule::RankBased: {
+        int weight = pheromoneSettings.rankedAnts;
+        // ties broken by ant index, the order stable_sort would keep, without its temporary buffer
+        std::sort(arrivedAnts.begin(), arrivedAnts.end(), [this](int a, int b) {
+            return arrivedPathLength(a) < arrivedPathLength(b) || (arrivedPathLength(a) == arrivedPathLength(b) && a < b);
+        });
+        for (int rank = 1; rank < weight && rank <= (int)arrivedAnts.size(); ++rank) {
+            int ant = arrivedAnts[rank - 1];
+            depositAlongPath(arrivedPath(ant), arrivedPathSize(ant), (weight - rank) * Q / arrivedPathLength(ant));
+        }
+        if (!bestPath.empty()) {
+            depositAlongPath(bestPath.data(), (int)bestPath.size(), weight * Q / bestPathLength);
+        }
+        break;
+    }
+    case PheromoneRule::MaxMin: {
+        int interval = pheromoneSettings.bestSoFarInterval;
+        const int* depositPath = nullptr;
+        int depositSize = 0;
+        double depositLength = 0.0;
+        if (interval > 0 && (iteration + 1) % interval == 0 && !bestPath.empty()) {
+            depositPath = bestPath.data();
+            depositSize = (int)bestPath.size();
+            depositLength = bestPathLength;
+        }
+        else if (!arrivedAnts.empty()) {
+            int iterationBest = arrivedAnts[0];
+            for (int index : arrivedAnts) {
+                if (arrivedPathLength(index) < arrivedPathLength(iterationBest)) iterationBest = index;
+            }
+            depositPath = arrivedPath(iterationBest);
+            depositSize = arrivedPathSize(iterationBest);
+            depositLength = arrivedPathLength(iterationBest);
+        }
+        if (depositPath) {
+            depositAlongPath(depositPath, depositSize, Q / depositLength);
+            for (int i = 0; i < depositSize; ++i) {
+                if (maxMin && pheromones.value(depositPath[i]) > tauMax) pheromones.set(depositPath[i], tauMax);
+            }
+        }
+        break;
+    }
+    }
+}
+
+void AntColonyBase::setStoppingCriteria(const StoppingCriteria& criteria) {
+    stoppingCriteria = criteria;
+}
+
+void AntColonyBase::setReplanSettings(const ReplanSettings& settings) {
+    replanSettings = settings;
+}
+
+void AntColonyBase::setConstructionSettings(const ConstructionSettings& settings) {
+    constructionSettings = settings; // marks and heuristic tables follow on the next iteration, see prepareConstruction
+}
+
+void AntColonyBase::setEvaporationRate(double rate) {
+    if (!(rate > 0.0 && rate <= 1.0)) {
+        throw std::invalid_argument("evaporation rate must be in (0, 1]");
+    }
+    evaporationRate = rate;
+}
+
+void AntColonyBase::setMaxIterations(int iterations) {
+    maxIterations = iterations;
+}
+
+bool AntColonyBase::acceptPath(const std::vector<int>& path) {
+    if (path.size() < 2 || path.front() != startCell || path.back() != endCell) return false;
+    const NeighborTable& neighbors = getNeighbors();
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        if (std::find(neighbors.begin(path[i]), neighbors.end(path[i]), path[i + 1]) == neighbors.end(path[i])) return false;
+    }
+    double length = getPathLength(path.data(), (int)path.size());
+    depositAlongPath(path.data(), (int)path.size(), Q / length);
+    if (pheromoneSettings.rule == PheromoneRule::MaxMin && tauMax > 0.0) {
+        for (int cell : path) {
+            if (pheromones.value(cell) > tauMax) pheromones.set(cell, tauMax);
+        }
+    }
+    if (bestPath.empty() || length < bestPathLength) {
+        bestPath = path;
+        bestPathLength = length;
+    }
+    return true;
+}
+
+// 地图变化后继续迭代，只处理变化的格子附近
+void AntColonyBase::onMapChanged(const std::vector<int>& cells) {
+    if (distanceFields) {
+        // walking distances change well beyond the changed cells, so the whole table is rebuilt
+        heuristicDistances = distanceFields->get(map, endCell, getConnectivity());
+        heuristicTable.reset();
+        ownHeuristicTable.reset();
+        if (startHeuristicDistances) startHeuristicDistances = distanceFields->get(map, startCell, getConnectivity());
+    }
+    // distances to start change as well; rebuilt on the next iteration
+    backwardHeuristicTable.clear();
+    updateHeuristic(cells);
+    smoothPheromones(cells);
+    if (corridors) buildCorridors();
+    if (!bestPath.empty() && !repairBestPath()) {
+        bestPath.clear();
+        bestPathLength = 9999999;
+    }
+}
+
+// Free cells around each changed cell get the average of their window, so trails
+// through a new obstacle no longer stand out and a freed cell starts out average.
+void AntColonyBase::smoothPheromones(const std::vector<int>& cells) {
+    int radius = replanSettings.pheromoneRadius;
+    for (int cell : cells) {
+        int x0 = std::max(0, map.cellX(cell) - radius), x1 = std::min(map.getWidth() - 1, map.cellX(cell) + radius);
+        int y0 = std::max(0, map.cellY(cell) - radius), y1 = std::min(map.getHeight() - 1, map.cellY(cell) + radius);
+        double sum = 0.0;
+        int count = 0;
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                if (map.isObstacle(x, y) || map.cellId(x, y) == cell) continue;
+                sum += pheromones.value(map.cellId(x, y));
+                ++count;
+            }
+        }
+        if (count == 0) continue;
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                if (!map.isObstacle(x, y)) pheromones.set(map.cellId(x, y), sum / count);
+            }
+        }
+    }
+}
+
+// Replaces the stretch of the best path between its first and last broken step by
+// the shortest detour within repairRadius of it. Returns false if there is none.
+bool AntColonyBase::repairBestPath() {
+    const NeighborTable& neighbors = getNeighbors();
+    auto connected = [&](int from, int to) {
+        return std::find(neighbors.begin(from), neighbors.end(from), to) != neighbors.end(from);
+    };
+    int size = (int)bestPath.size();
+    int first = -1, last = -1;
+    for (int i = 0; i + 1 < size; ++i) {
+        if (!connected(bestPath[i], bestPath[i + 1])) {
+            if (first < 0) first = i;
+            last = i + 1;
+        }
+    }
+    if (first < 0) return true;
+    int from = bestPath[first], to = bestPath[last];
+    if (map.isObstacle(from) || map.isObstacle(to)) return false;
+
+    int radius = replanSettings.repairRadius;
+    int x0 = map.getWidth(), y0 = map.getHeight(), x1 = 0, y1 = 0;
+    for (int i = first; i <= last; ++i) {
+        x0 = std::min(x0, map.cellX(bestPath[i]));
+        x1 = std::max(x1, map.cellX(bestPath[i]));
+        y0 = std::min(y0, map.cellY(bestPath[i]));
+        y1 = std::max(y1, map.cellY(bestPath[i]));
+    }
+    x0 = std::max(0, x0 - radius);
+    y0 = std::max(0, y0 - radius);
+    x1 = std::min(map.getWidth() - 1, x1 + radius);
+    y1 = std::min(map.getHeight() - 1, y1 + radius);
+    int width = x1 - x0 + 1;
+    auto local = [&](int cell) { return (map.cellY(cell) - y0) * width + (map.cellX(cell) - x0); };
+    auto inside = [&](int cell) {
+        return map.cellX(cell) >= x0 && map.cellX(cell) <= x1 && map.cellY(cell) >= y0 && map.cellY(cell) <= y1;
+    };
+    // breadth-first search inside the window, parents indexed by window cell
+    std::vector<int> parent((size_t)width * (y1 - y0 + 1), -1);
+    std::vector<int> queue(1, from);
+    parent[local(from)] = from;
+    for (size_t head = 0; head < queue.size() && parent[local(to)] < 0; ++head) {
+        int cell = queue[head];
+        for (const int* next = neighbors.begin(cell); next != neighbors.end(cell); ++next) {
+            if (!inside(*next) || parent[local(*next)] >= 0) continue;
+            parent[local(*next)] = cell;
+            queue.push_back(*next);
+        }
+    }
+    if (parent[local(to)] < 0) return false;
+    std::vector<int> detour;
+    for (int cell = to; cell != from; cell = parent[local(cell)]) {
+        detour.push_back(cell);
+    }
+    std::reverse(detour.begin(), detour.end());
+    std::vector<int> repaired(bestPath.begin(), bestPath.begin() + first + 1);
+    repaired.insert(repaired.end(), detour.begin(), detour.end());
+    repaired.insert(repaired.end(), bestPath.begin() + last + 1, bestPath.end());
+    bestPath.swap(repaired);
+    bestPathLength = getPathLength(bestPath.data(), (int)bestPath.size());
+    return true;
+}
+
+// 归一化的信息素熵：1 表示均匀分布，越小说明信息素越集中
+double AntColonyBase::pheromoneEntropy() const {
+    double total = 0.0;
+    int cells = 0;
+    for (int cell = 0; cell < map.getCellCount(); ++cell) {
+        if (map.isObstacle(cell)) continue;
+        total += pheromones.value(cell);
+        ++cells;
+    }
+    if (cells < 2 || total <= 0.0) return 0.0;
+    double entropy = 0.0;
+    for (int cell = 0; cell < map.getCellCount(); ++cell) {
+        if (map.isObstacle(cell) || pheromones.value(cell) <= 0.0) continue;
+        double p = pheromones.value(cell) / total;
+        entropy -= p * log(p);
+    }
+    return entropy / log((double)cells);
+}
+
+void AntColonyBase::run() {
+    runState = RunState::Idle;
+    resume(maxIterations);
+}
+
+void AntColonyBase::startRun() {
+    initializeWorkers();
+    telemetry.reset();
+    if (!telemetrySettings.path.empty()) {
+        telemetry.reset(new TelemetryWriter(telemetrySettings, map.getWidth(), map.getHeight()));
+    }
+    startTime = std::chrono::steady_clock::now();
+    lastBestPathLength = bestPathLength;
+    reportedLength = -1.0;
+    stalledIterations = 0;
+    nextIteration = 0;
+    iterationsRun = 0;
+    antSteps = 0;
+    // sized up front so that the iterations themselves do not allocate
+    bestPath.reserve(getMaxSteps() + 1);
+    // pheromone tiles of the box around start and goal, plus a tile on every side;
+    // trails beyond it grow the pool geometrically, so rarely
+    pheromones.reserveRegion(std::min(map.cellX(startCell), map.cellX(endCell)) - PheromoneField::tileSize,
+                             std::min(map.cellY(startCell), map.cellY(endCell)) - PheromoneField::tileSize,
+                             std::max(map.cellX(startCell), map.cellX(endCell)) + PheromoneField::tileSize,
+                             std::max(map.cellY(startCell), map.cellY(endCell)) + PheromoneField::tileSize);
+    arrivedAnts.reserve(antCount);
+    metrics.reset(maxIterations);
+    lastProgressTime = 0.0;
+    lastProgressIteration = -1;
+    runState = RunState::Paused;
+}
+
+bool AntColonyBase::resume(int iterations) {
+    if (runState == RunState::Finished) return false;
+    if (runState == RunState::Idle) startRun();
+    int last = iterations < maxIterations - nextIteration ? nextIteration + iterations : maxIterations;
+    bool stopped = false;
+    while (nextIteration < last && !stopRequested) {
+        int iteration = nextIteration++;
+        buildHeuristicTable(); // any dropped by a setter, also from a callback during the run
+        prepareConstruction();
+        initializeAnts();
+        {
+            ANTCOLONY_METRICS_TIMER(metrics.phaseSeconds[ConstructionPhase]);
+            constructSolutions();
+        }
+        {
+            ANTCOLONY_METRICS_TIMER(metrics.phaseSeconds[CollectionPhase]);
+            collectArrivedAnts();
+        }
+        updatePheromones(iteration);
+        double sumArrivedPathLength = 0;
+        int antArrivedCount = (int)arrivedAnts.size();
+        for (int ant : arrivedAnts) {
+            sumArrivedPathLength += arrivedPathLength(ant);
+        }
+        ++iterationsRun;
+        ANTCOLONY_METRICS_ADD(metrics.counters[IterationsCounter], 1);
+#if ANTCOLONY_METRICS
+        metrics.arrivalsPerIteration.push_back(antArrivedCount);
+#endif
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        if (telemetry) {
+            ANTCOLONY_METRICS_TIMER(metrics.phaseSeconds[TelemetryPhase]);
+            TelemetryIterationStats stats = {};
+            stats.bestPathLength = bestPath.empty() ? -1.0 : bestPathLength;
+            stats.averagePathLength = antArrivedCount ? sumArrivedPathLength / antArrivedCount : -1.0;
+            stats.elapsedSeconds = elapsed.count();
+            stats.arrivedAnts = antArrivedCount;
+            telemetry->recordIteration(iteration, stats);
+            if (telemetry->wantsSnapshot(iteration)) {
+                telemetry->recordPheromones(iteration, pheromones);
+            }
+        }
+        reportProgress(antArrivedCount, elapsed.count(), false);
+        if (!bestPath.empty() && (reportedLength < 0.0 || bestPathLength < reportedLength)) {
+            reportedLength = bestPathLength;
+            reportImprovement(antArrivedCount, elapsed.count());
+        }
+
+        // 停止条件
+        stalledIterations = bestPathLength < lastBestPathLength ? 0 : stalledIterations + 1;
+        lastBestPathLength = bestPathLength;
+        stopped = (stoppingCriteria.stallIterations > 0 && stalledIterations >= stoppingCriteria.stallIterations) ||
+                  (stoppingCriteria.entropyThreshold > 0.0 && pheromoneEntropy() < stoppingCriteria.entropyThreshold) ||
+                  (stoppingCriteria.timeBudgetSeconds > 0.0 && elapsed.count() >= stoppingCriteria.timeBudgetSeconds);
+        if (stopped) break;
+    }
+    if (!stopped && !stopRequested && nextIteration < maxIterations) return true;
+    finishRun();
+    return false;
+}
+
+void AntColonyBase::finishRun() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    reportProgress((int)arrivedAnts.size(), elapsed.count(), true);
+    telemetry.reset(); // drains the queue and writes the index
+    runState = RunState::Finished;
+    stopRequested = false;
+    //printBestPath();
+}
+
+void AntColonyBase::setTelemetry(const TelemetrySettings& settings) {
+    telemetrySettings = settings;
+}
+
+void AntColonyBase::setProgressCallback(const ProgressCallback& callback, double minIntervalSeconds) {
+    progressCallback = callback;
+    progressInterval = minIntervalSeconds;
+}
+
+void AntColonyBase::setImprovementCallback(const ProgressCallback& callback) {
+    improvementCallback = callback;
+}
+
+// 节流：两次回调之间至少间隔 progressInterval 秒，最后一次总会报告
+void AntColonyBase::reportProgress(int arrivedCount, double elapsedSeconds, bool finished) {
+    if (!progressCallback) return;
+    if (!finished && iterationsRun > 1 && elapsedSeconds - lastProgressTime < progressInterval) return;
+    if (finished && lastProgressIteration == iterationsRun) return;
+    lastProgressTime = elapsedSeconds;
+    lastProgressIteration = iterationsRun;
+    ProgressInfo info;
+    info.iteration = iterationsRun;
+    info.maxIterations = maxIterations;
+    info.bestPathLength = bestPath.empty() ? -1.0 : bestPathLength;
+    info.arrivedAnts = arrivedCount;
+    info.antSteps = antSteps;
+    info.elapsedSeconds = elapsedSeconds;
+    info.finished = finished;
+    info.colony = this;
+    progressCallback(info);
+}
+
+void AntColonyBase::reportImprovement(int arrivedCount, double elapsedSeconds) {
+    if (!improvementCallback) return;
+    ProgressInfo info;
+    info.iteration = iterationsRun;
+    info.maxIterations = maxIterations;
+    info.bestPathLength = bestPathLength;
+    info.arrivedAnts = arrivedCount;
+    info.antSteps = antSteps;
+    info.elapsedSeconds = elapsedSeconds;
+    info.finished = false;
+    info.colony = this;
+    improvementCallback(info);
+}
+
+int AntColonyBase::getMaxSteps() const { 
+    int deltaX = abs(start.first - end.first);
+    int deltaY = abs(start.second - end.second);
+    return (deltaX + deltaY) * 6;
+    //return (deltaX + 2) * (deltaY + 2);
+}
+
+void AntColonyBase::printBestPath() const {
+    if (bestPath.empty()) {
+        std::cout << "No path found." << std::endl;
+        return;
+    }
+
+    std::cout << "Best path length: " << bestPathLength << std::endl;
+    std::cout << "Best path visual representation with (0,0) at bottom left:" << std::endl;
+
+    // 创建网格
+    std::vector<std::vector<char>> grid(map.getHeight(), std::vector<char>(map.getWidth(), ' '));
+
+    // 标注障碍物
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            if (map.isObstacle(x, y)) {
+                grid[map.getHeight() - y - 1][x] = 'X';
+            }
+        }
+    }
+
+    // 标注路径
+    for (const auto& node : bestPath) {
+        // Assuming y is inverted due to (0,0) being at the bottom left
+        grid[map.getHeight() - map.cellY(node) - 1][map.cellX(node)] = '*';
+    }
+
+    // 画图
+    for (int y = 0; y < map.getHeight(); ++y) {
+        // 上边界
+        if (y == 0) {
+            for (int x = 0; x < map.getWidth(); ++x) {
+                std::cout << "+---";
+            }
+            std::cout << "+" << std::endl;
+        }
+
+        for (int x = 0; x < map.getWidth(); ++x) {
+            // 左边界
+            std::cout << "| " << grid[y][x]<<" ";
+        }
+        // 右边界
+        std::cout << "|" << std::endl;
+
+        // 下边界
+        for (int x = 0; x < map.getWidth(); ++x) {
+            std::cout << "+---";
+        }
+        std::cout << "+" << std::endl;
+    }
+}
+
+void AntColonyBase::printPheromones() const {
+    int width = map.getWidth(), height = map.getHeight();
+    for (int y = height - 1; y >= 0; --y) {
+        // 上边界
+        if (y == height - 1) {
+            std::cout << "+";
+            for (int x = 0; x < width; ++x) {
+                std::cout << "---+";
+            }
+            std::cout << std::endl;
+        }
+
+        // 信息素值和左右边界
+        for (int x = 0; x < width; ++x) {
+            if (x == 0) std::cout << "|";
+            double pheromone = pheromones.value(map.cellId(x, y));
+            // 显示信息素值的整数部分，每个数字占据三个字符的宽度，大于999显示999
+            if (pheromone < 999)
+                std::cout << std::setw(3) << std::setfill(' ') << static_cast<int>(pheromone) << "|";
+            else
+                std::cout << std::setw(3) << std::setfill(' ') << 999 << "|";
+        }
+        std::cout << std::endl;
+
+        // 下边界
+        std::cout << "+";
+        for (int x = 0; x < width; ++x) {
+            std::cout << "---+";
+        }
+        std::cout << std::endl;
+    }
+}
@@ -1,80 +1,670 @@
-/*
- * Copyright (c) 2024 Ch Oy @ NWPU
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#pragma once
-#ifndef ANTCOLONY_H
-#define ANTCOLONY_H
-
-#include "GridMap.h"
-#include <utility>
-#include <vector>
-#include <windows.h>
-#include <string>
-#include <iomanip>
-#include <fstream>
-
-struct Ant {
-    std::vector<std::pair<int, int>> path; // ߹·洢
-    double pathLength; // ߹·
-    bool arrived = false;
-    std::pair<int, int> currentPosition; // ϵĵǰλ
-    Ant(std::pair<int, int> start) : currentPosition(start), pathLength(0) {
-        path.push_back(start);
-    }
-};
-
-class AntColony {
-public:
-    AntColony(GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end);
-    void run();
-    void printBestPath() const; // ӡҵ·
-    void printPheromones() const;
-
-private:
-    GridMap& map;
-    std::vector<Ant> ants;
-    std::vector<std::vector<double>> pheromones; // Ϣؾ
-    std::pair<int, int> start, end;
-    int antCount; //
-    int maxIterations; // 
-    const double alpha = 1.0; // ϢصҪ
-    const double beta = 3.0; // ʽӵҪ
-    const double evaporationRate = 0.3; // Ϣص
-    const double Q = 100; // Ϣǿȳ
-    void initializeAnts();
-    void initializePheromones();
-    void moveAnts();
-    void updatePheromones();
-    int calculatePathLength(const std::vector<std::pair<int, int>>& path) const;
-    int chooseNextNode(const Ant& ant);
-    void evaluateAndUpdateBestPath(Ant& ant);
-    void printAntsDistribution() const;
-    void progressBar(int currentValue, int maximumValue, const std::string& prefix);
-    int getMaxSteps() const;
-    std::vector<std::pair<int, int>> getFeasibleNextNodes(const Ant& ant) const;
-    std::vector<std::pair<int, int>> bestPath; 
-    int bestPathLength = 9999999; 
-    void setCursorPosition(int x, int y);
-    void progressBar(int current, int total, const std::string& prefix, int barWidth, int posY);
-    void savePheromoneMatrixToCSV(const std::vector<std::vector<double>>& pheromones, int iteration);
-};
-
-#endif
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef ANTCOLONY_H
+#define ANTCOLONY_H
+
+#include "DistanceField.h"
+#include "GridMap.h"
+#include "Metrics.h"
+#include "PheromoneField.h"
+#include "Random.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
+#include "TransitionKernel.h"
+#include "TransitionPolicy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <functional>
+#include <string>
+#include <iomanip>
+
+// 蚁群状态，每个字段单独存放 (structure of arrays)，下标为蚂蚁编号
+struct ColonyState {
+    std::vector<int> positions; // 蚂蚁的当前位置
+    std::vector<int> previous; // 上一步的位置，起点处为 -1
+    std::vector<double> pathLengths; // 蚂蚁走过的路径长度
+    std::vector<unsigned char> alive; // 1 while the ant can still move
+    std::vector<unsigned char> arrived;
+    // 蚂蚁走过的路径（格子编号）放在一整块预先分配的内存里，
+    // 蚂蚁 i 的路径从 pathNodes[i * pathStride] 开始，共 pathSizes[i] 个格子
+    std::vector<int> pathNodes;
+    std::vector<int> pathSizes;
+    int pathStride = 0; // the step budget plus the start cell
+    int size() const { return (int)positions.size(); }
+    const int* path(int ant) const { return pathNodes.data() + (size_t)ant * pathStride; }
+    int* path(int ant) { return pathNodes.data() + (size_t)ant * pathStride; }
+    int pathSize(int ant) const { return pathSizes[ant]; }
+    void extendPath(int ant, int cell) { pathNodes[(size_t)ant * pathStride + pathSizes[ant]++] = cell; }
+    // Reuses the storage of the previous iteration, so it only allocates when the
+    // colony or its step budget grows.
+    void reset(int antCount, int start, int maxSteps) {
+        positions.assign(antCount, start);
+        previous.assign(antCount, -1);
+        pathLengths.assign(antCount, 0.0);
+        alive.assign(antCount, 1);
+        arrived.assign(antCount, 0);
+        pathStride = maxSteps + 1;
+        pathNodes.resize((size_t)antCount * pathStride);
+        pathSizes.assign(antCount, 1);
+        for (int ant = 0; ant < antCount; ++ant) {
+            pathNodes[(size_t)ant * pathStride] = start;
+        }
+    }
+};
+
+// 每次迭代结束时的信息素更新规则
+enum class PheromoneRule {
+    AntSystem, // every arrived ant deposits Q / L
+    Elitist,   // Ant System plus extra deposits on the best-so-far path
+    RankBased, // the best rankedAnts - 1 ants weighted by rank, plus the best-so-far path
+    MaxMin     // a single ant deposits and values are kept within [tauMin, tauMax]
+};
+
+struct PheromoneSettings {
+    PheromoneRule rule = PheromoneRule::AntSystem;
+    double elitistWeight = 5.0; // Elitist: weight of the best-so-far path
+    int rankedAnts = 6; // RankBased: w
+    double bestProbability = 0.05; // MaxMin: p_best, sets the tauMin / tauMax ratio
+    double averageBranching = 2.0; // MaxMin: average number of choices per step
+    int bestSoFarInterval = 10; // MaxMin: every n-th iteration the best-so-far path deposits, 0 never
+};
+
+// 迭代之间的停止条件，0 表示不启用
+struct StoppingCriteria {
+    int stallIterations = 0; // best path length unchanged for this many iterations
+    double entropyThreshold = 0.0; // normalized pheromone entropy over passable cells, in [0, 1]
+    double timeBudgetSeconds = 0.0; // wall-clock budget for run()
+};
+
+// 构造路径的方式，默认只禁止直接走回头路
+struct ConstructionSettings {
+    bool avoidVisited = false; // ants never re-enter a cell of their own and back up out of dead ends
+    bool eraseLoops = false; // cut the cycles out of arrived paths before they deposit and compete for the best path
+    // Half the ants walk from end toward start first; the other half arrive as soon
+    // as they step onto a cell one of them reached and follow its trail on to end.
+    bool bidirectional = false;
+    // Ants entering a corridor (see GridMap::findCorridors) follow it to its far end
+    // without a roulette draw per cell. Only for the step loop, not avoidVisited.
+    bool compressCorridors = false;
+};
+
+// Marks on map cells that are cleared by moving on to the next epoch instead of
+// writing the whole array.
+struct CellMarks {
+    std::vector<uint32_t> stamps;
+    std::vector<int> values; // optional payload per marked cell
+    uint32_t epoch = 0;
+    void prepare(int cellCount, bool withValues) {
+        if ((int)stamps.size() != cellCount) {
+            stamps.assign(cellCount, 0);
+            epoch = 0;
+        }
+        values.resize(withValues ? cellCount : 0);
+    }
+    void next() {
+        if (++epoch == 0) { // wrapped around, the only time the stamps are cleared
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+    bool marked(int cell) const { return stamps[cell] == epoch; }
+    void mark(int cell) { stamps[cell] = epoch; }
+    void unmark(int cell) { stamps[cell] = 0; }
+};
+
+// 地图通过 GridMap::applyChanges 变化后的局部处理
+struct ReplanSettings {
+    int pheromoneRadius = 2; // free cells this close to a changed cell share the window's average pheromone
+    int repairRadius = 16; // margin around a broken stretch of the best path searched for a detour
+};
+
+class AntColonyBase;
+
+// 进度信息，每次迭代结束后在调用 run() 的线程上回调
+struct ProgressInfo {
+    int iteration; // iterations completed so far
+    int maxIterations;
+    double bestPathLength; // -1 while no ant has arrived
+    int arrivedAnts; // in the last iteration
+    long long antSteps; // moves made by all ants since run() started
+    double elapsedSeconds;
+    bool finished; // last report of this run
+    const AntColonyBase* colony;
+};
+
+typedef std::function<void(const ProgressInfo&)> ProgressCallback;
+
+// Everything except the transition rule: iterations, pheromone update, best path and output.
+class AntColonyBase {
+public:
+    AntColonyBase(const GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end);
+    virtual ~AntColonyBase();
+    void run();
+    // Runs at most `iterations` more iterations and returns true if the run is
+    // paused rather than over. The next call continues it: iteration numbers,
+    // the stall count, the clock, telemetry and the counters carry on. A run is
+    // over after maxIterations, a stopping criterion or a stop request; further
+    // calls then return false until run() starts a new one. With no run started,
+    // the first call starts one. run() is a fresh start resumed for maxIterations.
+    bool resume(int iterations);
+    void setThreadCount(int threadCount); // 1 runs tour construction on the calling thread
+    void setSeed(uint64_t seed);
+    void setPheromoneSettings(const PheromoneSettings& settings);
+    void setStoppingCriteria(const StoppingCriteria& criteria);
+    const StoppingCriteria& getStoppingCriteria() const { return stoppingCriteria; }
+    // Thread-safe: run() returns after the iteration in progress. A request made
+    // before run() starts stops it before its first iteration; withdrawStop()
+    // drops one that came too late to stop anything.
+    void requestStop() { stopRequested = true; }
+    void withdrawStop() { stopRequested = false; }
+    // The colony follows GridMap::applyChanges on its map, also from inside a
+    // progress callback, and keeps its pheromones and, where possible, its best path.
+    void setReplanSettings(const ReplanSettings& settings);
+    void setConstructionSettings(const ConstructionSettings& settings);
+    void setEvaporationRate(double rate); // in (0, 1]
+    void setMaxIterations(int iterations); // for the next run(), which continues from the current field
+    // A path found elsewhere, e.g. by another colony: deposited like one more
+    // arrived ant and kept as the best path if it is shorter. Ignored unless it
+    // leads from start to end along the neighbor table.
+    bool acceptPath(const std::vector<int>& path);
+    int getIterationsRun() const { return iterationsRun; } // of this run, over all resume() calls
+    long long getAntSteps() const { return antSteps; }
+    double getBestPathLength() const { return bestPath.empty() ? -1.0 : bestPathLength; }
+    const std::vector<int>& getBestPath() const { return bestPath; } // cell ids from start to end, empty if none
+    // run() itself never writes to the console; progress goes to this callback
+    // at most once per minIntervalSeconds, plus a final report.
+    void setProgressCallback(const ProgressCallback& callback, double minIntervalSeconds = 0.1);
+    // Called on the run() thread after each iteration that shortened the best path,
+    // unthrottled; getBestPath() on info.colony is safe to read from it.
+    void setImprovementCallback(const ProgressCallback& callback);
+    void setTelemetry(const TelemetrySettings& settings); // written to settings.path during run(), off by default
+    void setHeuristicDistances(const std::vector<double>& distances); // per cell, for LookupTableHeuristic
+    void setHeuristicDistances(std::shared_ptr<const std::vector<double>> distances); // shared, e.g. from a DistanceFieldCache
+    // Walking distances to the goal from cache, for this colony's connectivity,
+    // and fetched again for the new map contents on GridMap::applyChanges, as are
+    // distances to start if any were set. Distances set the other ways stay as
+    // given when the map changes.
+    void setHeuristicDistances(DistanceFieldCache& cache);
+    // Distances to start for the backward ants of a bidirectional colony.
+    void setStartHeuristicDistances(std::shared_ptr<const std::vector<double>> distances);
+    // Takes the heuristic table from cache, which builds it on the first request,
+    // instead of building one for this colony. Call after the settings it depends
+    // on (setExponents, setHeuristicDistances), as they drop it again.
+    virtual void borrowHeuristicTable(HeuristicTableCache& cache) = 0;
+    // Warm start: replaces the uniform initial field, e.g. with one saved in a PheromoneCache.
+    void setPheromones(const std::vector<double>& values);
+    void setPheromones(const PheromoneField& field);
+    const PheromoneField& getPheromones() const { return pheromones; }
+    const ColonyMetrics& getMetrics() const { return metrics; } // of the last run(), see Metrics.h
+    void printBestPath() const; // 打印找到的最佳路径
+    void printPheromones() const;
+
+protected:
+    const GridMap& map;
+    ColonyState ants;
+    PheromoneField pheromones; // 信息素矩阵, indexed by cell id, tiled and evaporated lazily
+    // 启发式因子的 beta 次方, indexed by cell id; built on the next iteration when
+    // null, and possibly borrowed from a HeuristicTableCache
+    std::shared_ptr<const std::vector<double>> heuristicTable;
+    std::shared_ptr<std::vector<double>> ownHeuristicTable; // heuristicTable unless it is borrowed
+    std::shared_ptr<const std::vector<double>> heuristicDistances;
+    DistanceFieldCache* distanceFields = nullptr; // source of heuristicDistances, if they follow the map
+    // bidirectional: ants heading from end to start, their heuristic and the cells they reached
+    ColonyState backwardAnts;
+    std::vector<double> backwardHeuristicTable;
+    std::shared_ptr<const std::vector<double>> startHeuristicDistances;
+    CellMarks trailMarks; // value: offset of the cell in backwardAnts.pathNodes
+    std::pair<int, int> start, end;
+    int startCell, endCell;
+    int antCount; //蚂蚁数量
+    int maxIterations; // 最大迭代次数
+    double evaporationRate = 0.3; // 信息素的蒸发率
+    const double Q = 100; // 信息素强度常数
+    int threadCount = 1;
+    uint64_t seed = 1;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<RandomLanes> generators; // one per construction worker
+    std::vector<std::vector<int>> activeAnts; // per worker, ants that can still move
+    ConstructionSettings constructionSettings;
+    std::vector<CellMarks> visitedMarks; // avoidVisited: one per worker and lane
+    std::vector<long long> backtrackSteps; // avoidVisited: per worker, moves no longer on the paths
+    std::vector<long long> candidateCounts; // per worker, for CandidatesCounter
+    ColonyMetrics metrics;
+    std::unique_ptr<CorridorTable> corridors; // compressCorridors, rebuilt when the map changes
+    void buildCorridors();
+    // The ants of one construction pass and where they head. A bidirectional
+    // colony runs the backward pass first and marks its trails for the forward one.
+    struct Walk {
+        ColonyState* ants;
+        int origin, goal;
+        const double* heuristic; // toward goal, indexed by cell id
+        const CellMarks* trails; // forward pass of a bidirectional colony, else null
+        const CorridorTable* corridors; // compressCorridors, else null
+        int maxCells; // paths end once they hold this many cells
+        bool arrives(int cell) const { return cell == goal || (trails && trails->marked(cell)); }
+    };
+    Walk forwardWalk();
+    Walk backwardWalk();
+    void markTrails();
+    int getMaxSteps() const;
+    virtual void buildHeuristicTable() = 0; // whichever table is missing
+    virtual void updateHeuristic(const std::vector<int>& cells) = 0;
+    virtual void constructSolutions() = 0;
+    virtual const NeighborTable& getNeighbors() const = 0;
+    virtual int getConnectivity() const = 0;
+    virtual double getPathLength(const int* path, int size) const = 0;
+
+private:
+    void initializeAnts();
+    void initializePheromones();
+    void initializeWorkers();
+    void prepareConstruction();
+    PheromoneSettings pheromoneSettings;
+    StoppingCriteria stoppingCriteria;
+    int iterationsRun = 0;
+    long long antSteps = 0;
+    // state of the run in progress, kept between resume() calls
+    enum class RunState { Idle, Paused, Finished };
+    RunState runState = RunState::Idle;
+    int nextIteration = 0;
+    int stalledIterations = 0;
+    double lastBestPathLength = 0.0;
+    double reportedLength = -1.0; // the best path passed to improvementCallback, -1 before the first
+    std::chrono::steady_clock::time_point startTime;
+    std::unique_ptr<TelemetryWriter> telemetry;
+    void startRun();
+    void finishRun();
+    double pheromoneEntropy() const;
+    // in ant order: i for ant i of ants, then ants.size() + i for backward ant i
+    // that reached start by itself, whose path collectArrivedAnts turned around
+    std::vector<int> arrivedAnts;
+    const ColonyState& arrivedState(int index) const { return index < ants.size() ? ants : backwardAnts; }
+    int arrivedAnt(int index) const { return index < ants.size() ? index : index - ants.size(); }
+    const int* arrivedPath(int index) const { return arrivedState(index).path(arrivedAnt(index)); }
+    int arrivedPathSize(int index) const { return arrivedState(index).pathSize(arrivedAnt(index)); }
+    double arrivedPathLength(int index) const { return arrivedState(index).pathLengths[arrivedAnt(index)]; }
+    double tauMin = 0.0, tauMax = 0.0;
+    void collectArrivedAnts();
+    CellMarks loopMarks; // eraseLoops: position of each cell on the path being erased
+    void eraseLoops(ColonyState& walkers, int ant);
+    void joinTrail(int ant);
+    void updatePheromones(int iteration);
+    void updateMaxMinBounds();
+    void depositAlongPath(const int* path, int size, double amount);
+    void printAntsDistribution() const;
+    std::vector<int> bestPath; 
+    double bestPathLength = 9999999; 
+    ProgressCallback progressCallback;
+    ProgressCallback improvementCallback;
+    std::atomic<bool> stopRequested{ false };
+    double progressInterval = 0.1;
+    double lastProgressTime = 0.0;
+    int lastProgressIteration = -1;
+    void reportProgress(int arrivedCount, double elapsedSeconds, bool finished);
+    void reportImprovement(int arrivedCount, double elapsedSeconds);
+    TelemetrySettings telemetrySettings;
+    ReplanSettings replanSettings;
+    int mapListener;
+    void onMapChanged(const std::vector<int>& cells);
+    void smoothPheromones(const std::vector<int>& cells);
+    bool repairBestPath();
+};
+
+// The transition rule specialized on its policies (see TransitionPolicy.h).
+template <class Neighborhood = FourConnected, class Heuristic = EuclideanHeuristic,
+          class Alpha = IntExponent<1>, class Beta = IntExponent<3>>
+class BasicAntColony : public AntColonyBase {
+public:
+    BasicAntColony(const GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end)
+        : AntColonyBase(map, antCount, maxIterations, start, end) {}
+
+    // Only for RuntimeExponent policies, e.g. TunableAntColony.
+    void setExponents(double alphaValue, double betaValue);
+    void borrowHeuristicTable(HeuristicTableCache& cache) override;
+
+protected:
+    void buildHeuristicTable() override;
+    void updateHeuristic(const std::vector<int>& cells) override;
+    void constructSolutions() override;
+    const NeighborTable& getNeighbors() const override { return map.getNeighborTable(Neighborhood::connectivity); }
+    int getConnectivity() const override { return Neighborhood::connectivity; }
+    double getPathLength(const int* path, int size) const override;
+
+private:
+    static const int lanes = RandomLanes::lanes;
+    Alpha alpha;
+    Beta beta;
+    double heuristicAt(int cell, int goal, const std::vector<double>* distances) const;
+    std::vector<double> computeHeuristicTable() const;
+    void construct(const Walk& walk, int maxSteps);
+    void followCorridor(const Walk& walk, int ant);
+    void moveBlock(const Walk& walk, const int* block, int count, RandomLanes& random, const NeighborTable& neighbors, long long& candidates);
+    void walkWithoutRevisits(const Walk& walk, int worker, int first, int last, const NeighborTable& neighbors, int maxSteps);
+    int getFeasibleNextNodes(const ColonyState& walkers, int ant, const NeighborTable& neighbors, int* nextNodes) const;
+};
+
+// alpha = 1, beta = 3, 4-connected grid with the straight-line distance heuristic
+typedef BasicAntColony<> AntColony;
+// Guided by walking distances set with setHeuristicDistances (see DistanceField.h).
+// Neighbors differ by one step, so (d / (d - 1))^beta must stay well above 1 far
+// from the goal: beta = 16 lets most ants arrive on 64x64 maps where beta = 3 does not.
+typedef BasicAntColony<FourConnected, LookupTableHeuristic, IntExponent<1>, IntExponent<16>> GeodesicAntColony;
+// alpha and beta set per colony with setExponents, 1 until then; slower than AntColony.
+typedef BasicAntColony<FourConnected, EuclideanHeuristic, RuntimeExponent, RuntimeExponent> TunableAntColony;
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::setExponents(double alphaValue, double betaValue) {
+    alpha.exponent = alphaValue;
+    beta.exponent = betaValue;
+    heuristicTable.reset();
+    ownHeuristicTable.reset();
+    backwardHeuristicTable.clear();
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::borrowHeuristicTable(HeuristicTableCache& cache) {
+    heuristicTable = cache.get(map, endCell, beta.value(), Heuristic::name(), [this] { return computeHeuristicTable(); });
+    ownHeuristicTable.reset();
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+double BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::heuristicAt(int cell, int goal, const std::vector<double>* distances) const {
+    if (map.isObstacle(cell) || cell == goal) return 0.0;
+    static const std::vector<double> noDistances;
+    double distance = Heuristic::distance(map, cell, goal, distances ? *distances : noDistances);
+    // 以距离的倒数作为启发式信息
+    return distance > 0.0 ? beta.apply(1.0 / distance) : 0.0;
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+std::vector<double> BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::computeHeuristicTable() const {
+    std::vector<double> table(map.getCellCount());
+    for (int cell = 0; cell < map.getCellCount(); ++cell) {
+        table[cell] = heuristicAt(cell, endCell, heuristicDistances.get());
+    }
+    return table;
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::buildHeuristicTable() {
+    if (!heuristicTable) {
+        ownHeuristicTable = std::make_shared<std::vector<double>>(computeHeuristicTable());
+        heuristicTable = ownHeuristicTable;
+    }
+    if (!constructionSettings.bidirectional) {
+        backwardHeuristicTable.clear();
+    }
+    else if (backwardHeuristicTable.empty()) {
+        backwardHeuristicTable.resize(map.getCellCount());
+        for (int cell = 0; cell < map.getCellCount(); ++cell) {
+            backwardHeuristicTable[cell] = heuristicAt(cell, startCell, startHeuristicDistances.get());
+        }
+    }
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::updateHeuristic(const std::vector<int>& cells) {
+    if (heuristicTable && heuristicTable != ownHeuristicTable) {
+        // a borrowed table is shared with other colonies, so it is copied before it changes
+        ownHeuristicTable = std::make_shared<std::vector<double>>(*heuristicTable);
+        heuristicTable = ownHeuristicTable;
+    }
+    for (int cell : cells) {
+        if (ownHeuristicTable) (*ownHeuristicTable)[cell] = heuristicAt(cell, endCell, heuristicDistances.get());
+    }
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+double BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::getPathLength(const int* path, int size) const {
+    double length = 0.0;
+    for (int i = 1; i < size; ++i) {
+        length += Neighborhood::stepCost(path[i - 1], path[i], map.getWidth());
+    }
+    return length;
+}
+
+// 每个工作线程负责一段连续的蚂蚁，迭代内信息素只读，沉积留到 updatePheromones 统一进行
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::constructSolutions() {
+    int maxSteps = getMaxSteps();
+    if (constructionSettings.bidirectional) {
+        construct(backwardWalk(), maxSteps);
+        markTrails();
+    }
+    construct(forwardWalk(), maxSteps);
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::construct(const Walk& walk, int maxSteps) {
+    const NeighborTable& neighbors = map.getNeighborTable(Neighborhood::connectivity);
+    int workerCount = (int)generators.size();
+    int antTotal = walk.ants->size();
+    auto constructRange = [&](int worker) {
+        int first = (int)((long long)antTotal * worker / workerCount);
+        int last = (int)((long long)antTotal * (worker + 1) / workerCount);
+        if (constructionSettings.avoidVisited) {
+            walkWithoutRevisits(walk, worker, first, last, neighbors, maxSteps);
+            return;
+        }
+        RandomLanes& random = generators[worker];
+        std::vector<int>& active = activeAnts[worker];
+        active.clear();
+        for (int i = first; i < last; ++i) {
+            active.push_back(i);
+        }
+        // 只处理仍在移动的蚂蚁，全部到达或陷入死路后提前结束
+        for (int step = 0; step < maxSteps && !active.empty(); ++step) {
+            int count = (int)active.size();
+            for (int i = 0; i < count; i += lanes) {
+                moveBlock(walk, &active[i], count - i < lanes ? count - i : lanes, random, neighbors, candidateCounts[worker]);
+            }
+            int kept = 0;
+            for (int i = 0; i < count; ++i) {
+                int ant = active[i];
+                if (walk.ants->alive[ant] && walk.ants->pathSize(ant) < walk.maxCells) active[kept++] = ant;
+            }
+            active.resize(kept);
+        }
+    };
+    if (pool) {
+        // a single reference fits std::function's small buffer, so this does not allocate
+        pool->parallelFor(workerCount, [&constructRange](int worker) { constructRange(worker); });
+    }
+    else {
+        constructRange(0);
+    }
+}
+
+// Advances the count (at most lanes) live ants listed in block by one step.
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::moveBlock(const Walk& walk, const int* block, int count, RandomLanes& random, const NeighborTable& neighbors,
+                                                                   long long& candidates) {
+    ColonyState& walkers = *walk.ants;
+    int nextNodes[lanes][Neighborhood::maxDegree] = {};
+    int counts[lanes] = {};
+    int choices[lanes];
+    int moving = 0;
+    for (int lane = 0; lane < count; ++lane) {
+        int ant = block[lane];
+        counts[lane] = getFeasibleNextNodes(walkers, ant, neighbors, nextNodes[lane]);
+        if (counts[lane] == 0) {
+            walkers.alive[ant] = 0; // 无路可走，之后也不会再有
+        }
+        moving += counts[lane] > 0;
+        ANTCOLONY_METRICS_ADD(candidates, counts[lane]);
+    }
+    if (moving == 0) return;
+    selectNextNodes<Alpha, Neighborhood::maxDegree>(nextNodes, counts, pheromones, walk.heuristic, alpha, random, choices);
+    for (int lane = 0; lane < count; ++lane) {
+        if (counts[lane] == 0) continue;
+        int ant = block[lane];
+        int choice = choices[lane];
+        for (int k = 0; k < counts[lane]; ++k) {
+            // 终点的启发式因子视为无穷大，相邻时直接选择
+            if (nextNodes[lane][k] == walk.goal) choice = k;
+        }
+        int current = walkers.positions[ant];
+        int next = nextNodes[lane][choice];
+        walkers.pathLengths[ant] += Neighborhood::stepCost(current, next, map.getWidth());
+        walkers.previous[ant] = current;
+        walkers.positions[ant] = next;
+        walkers.extendPath(ant, next);
+        if (walk.arrives(next)) {
+            walkers.arrived[ant] = 1;
+            walkers.alive[ant] = 0;
+        }
+        else if (walk.corridors && walk.corridors->isCorridor(next)) {
+            followCorridor(walk, ant);
+        }
+    }
+}
+
+// Moves an ant that has just entered a corridor on to the cell at its far end, or
+// as far as its path has room for.
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::followCorridor(const Walk& walk, int ant) {
+    ColonyState& walkers = *walk.ants;
+    const CorridorTable& corridors = *walk.corridors;
+    int index = corridors.position[walkers.positions[ant]];
+    int direction = corridors.cells[index - 1] == walkers.previous[ant] ? 1 : -1;
+    while (walkers.pathSize(ant) < walk.maxCells) {
+        int current = walkers.positions[ant];
+        index += direction;
+        int next = corridors.cells[index];
+        walkers.pathLengths[ant] += Neighborhood::stepCost(current, next, map.getWidth());
+        walkers.previous[ant] = current;
+        walkers.positions[ant] = next;
+        walkers.extendPath(ant, next);
+        if (walk.arrives(next)) {
+            walkers.arrived[ant] = 1;
+            walkers.alive[ant] = 0;
+            return;
+        }
+        if (!corridors.isCorridor(next)) return;
+    }
+}
+
+// avoidVisited: each lane walks one ant at a time, marking the cells it enters, and
+// takes the next ant of the range once its ant has arrived or given up. At a dead
+// end the ant steps back along its path; the cell it leaves stays marked.
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+void BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::walkWithoutRevisits(const Walk& walk, int worker, int first, int last, const NeighborTable& neighbors, int maxSteps) {
+    ColonyState& walkers = *walk.ants;
+    RandomLanes& random = generators[worker];
+    CellMarks* marks = &visitedMarks[(size_t)worker * lanes];
+    long long& backtracks = backtrackSteps[worker];
+    long long& candidates = candidateCounts[worker];
+    int slots[lanes], steps[lanes];
+    int nextAnt = first;
+    auto takeNextAnt = [&](int lane) {
+        slots[lane] = nextAnt < last ? nextAnt++ : -1;
+        steps[lane] = 0;
+        if (slots[lane] >= 0) {
+            marks[lane].next();
+            marks[lane].mark(walk.origin);
+        }
+    };
+    for (int lane = 0; lane < lanes; ++lane) {
+        takeNextAnt(lane);
+    }
+    int nextNodes[lanes][Neighborhood::maxDegree] = {};
+    int counts[lanes];
+    int choices[lanes];
+    while (true) {
+        int walking = 0, moving = 0;
+        for (int lane = 0; lane < lanes; ++lane) {
+            counts[lane] = 0;
+            if (slots[lane] < 0) continue;
+            ++walking;
+            int position = walkers.positions[slots[lane]];
+            for (const int* next = neighbors.begin(position); next != neighbors.end(position); ++next) {
+                if (!marks[lane].marked(*next)) nextNodes[lane][counts[lane]++] = *next;
+            }
+            moving += counts[lane] > 0;
+            ANTCOLONY_METRICS_ADD(candidates, counts[lane]);
+        }
+        if (walking == 0) break;
+        if (moving > 0) {
+            selectNextNodes<Alpha, Neighborhood::maxDegree>(nextNodes, counts, pheromones, walk.heuristic, alpha, random, choices);
+        }
+        for (int lane = 0; lane < lanes; ++lane) {
+            int ant = slots[lane];
+            if (ant < 0) continue;
+            int current = walkers.positions[ant];
+            if (counts[lane] == 0) {
+                int size = walkers.pathSizes[ant];
+                if (size == 1) { // 回到起点也无路可走
+                    walkers.alive[ant] = 0;
+                    takeNextAnt(lane);
+                    continue;
+                }
+                const int* path = walkers.path(ant);
+                walkers.pathLengths[ant] -= Neighborhood::stepCost(path[size - 2], current, map.getWidth());
+                walkers.positions[ant] = path[size - 2];
+                walkers.previous[ant] = size > 2 ? path[size - 3] : -1;
+                --walkers.pathSizes[ant];
+                backtracks += 2; // the move into the dead end and the one back out
+            }
+            else {
+                int choice = choices[lane];
+                for (int k = 0; k < counts[lane]; ++k) {
+                    if (nextNodes[lane][k] == walk.goal) choice = k;
+                }
+                int next = nextNodes[lane][choice];
+                walkers.pathLengths[ant] += Neighborhood::stepCost(current, next, map.getWidth());
+                walkers.previous[ant] = current;
+                walkers.positions[ant] = next;
+                walkers.extendPath(ant, next);
+                marks[lane].mark(next);
+                if (walk.arrives(next)) {
+                    walkers.arrived[ant] = 1;
+                    walkers.alive[ant] = 0;
+                    takeNextAnt(lane);
+                    continue;
+                }
+            }
+            if (++steps[lane] >= maxSteps) { // stays alive, like ants of the step loop that run out of steps
+                takeNextAnt(lane);
+            }
+        }
+    }
+}
+
+template <class Neighborhood, class Heuristic, class Alpha, class Beta>
+int BasicAntColony<Neighborhood, Heuristic, Alpha, Beta>::getFeasibleNextNodes(const ColonyState& walkers, int ant, const NeighborTable& neighbors, int* nextNodes) const {
+    int position = walkers.positions[ant];
+    int previous = walkers.previous[ant];
+    int count = 0;
+    for (const int* next = neighbors.begin(position); next != neighbors.end(position); ++next) {
+        if (*next != previous) //防止走回头路
+            nextNodes[count++] = *next;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "AnytimeRun.h"
+#include <chrono>
+
+std::unique_ptr<AnytimeRun> AnytimeRun::start(AntColonyBase& colony, double deadlineSeconds, const ImprovementCallback& onImprovement) {
+    return std::unique_ptr<AnytimeRun>(new AnytimeRun(colony, deadlineSeconds, onImprovement));
+}
+
+AnytimeRun::AnytimeRun(AntColonyBase& colony, double deadlineSeconds, const ImprovementCallback& onImprovement)
+    : colony(colony), onImprovement(onImprovement) {
+    StoppingCriteria saved = colony.getStoppingCriteria(), criteria = saved;
+    if (deadlineSeconds > 0.0 && (criteria.timeBudgetSeconds <= 0.0 || deadlineSeconds < criteria.timeBudgetSeconds)) {
+        criteria.timeBudgetSeconds = deadlineSeconds;
+    }
+    colony.setStoppingCriteria(criteria);
+    colony.setImprovementCallback([this](const ProgressInfo& info) { publish(info); });
+    thread = std::thread([this, saved] {
+        this->colony.run();
+        this->colony.setImprovementCallback(ProgressCallback());
+        this->colony.setStoppingCriteria(saved);
+        std::lock_guard<std::mutex> lock(mutex);
+        // a cancel() after run() returned must not stop the colony's next run
+        this->colony.withdrawStop();
+        done = true;
+        changed.notify_all();
+    });
+}
+
+AnytimeRun::~AnytimeRun() {
+    cancel();
+    thread.join();
+}
+
+void AnytimeRun::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!done) colony.requestStop(); // a finished colony would keep the request for its next run()
+}
+
+bool AnytimeRun::finished() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return done;
+}
+
+// The path is copied before the lock is taken, so readers only ever wait for a move.
+void AnytimeRun::publish(const ProgressInfo& info) {
+    PathSnapshot next;
+    next.path = info.colony->getBestPath();
+    next.length = info.bestPathLength;
+    next.iteration = info.iteration;
+    next.elapsedSeconds = info.elapsedSeconds;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        next.version = snapshot.version + 1;
+        snapshot = std::move(next);
+    }
+    changed.notify_all();
+    if (onImprovement) onImprovement(snapshot); // only this thread writes it
+}
+
+PathSnapshot AnytimeRun::best() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return snapshot;
+}
+
+PathSnapshot AnytimeRun::waitForImprovement(int version, double timeoutSeconds) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto ready = [&] { return done || snapshot.version > version; };
+    if (timeoutSeconds < 0.0) {
+        changed.wait(lock, ready);
+    }
+    else {
+        changed.wait_for(lock, std::chrono::duration<double>(timeoutSeconds), ready);
+    }
+    return snapshot;
+}
+
+PathSnapshot AnytimeRun::wait() const {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return done; });
+    return snapshot;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef ANYTIMERUN_H
+#define ANYTIMERUN_H
+
+#include "AntColony.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The best path of a running colony at one point in time.
+struct PathSnapshot {
+    std::vector<int> path; // cell ids from start to end, empty while there is none
+    double length = -1.0; // -1 while there is no path
+    int iteration = 0; // iterations completed when it was found
+    double elapsedSeconds = 0.0; // since the run started
+    int version = 0; // improvements published so far
+};
+
+typedef std::function<void(const PathSnapshot&)> ImprovementCallback;
+
+// Runs a colony on a background thread and publishes each shorter best path as a
+// snapshot. Publishing happens between iterations, on the colony's thread, and
+// only copies the path; the construction loop never takes the lock readers use.
+// The colony must outlive the handle and is not to be touched otherwise until
+// the run has finished. Destroying the handle cancels the run and waits for it.
+class AnytimeRun {
+public:
+    // Starts colony.run() and returns at once. deadlineSeconds > 0 stops the run
+    // after the iteration that passes it (it tightens the colony's
+    // StoppingCriteria::timeBudgetSeconds for this run). onImprovement, if set, is
+    // called on the colony's thread with every snapshot.
+    static std::unique_ptr<AnytimeRun> start(AntColonyBase& colony, double deadlineSeconds = 0.0,
+                                             const ImprovementCallback& onImprovement = ImprovementCallback());
+    ~AnytimeRun();
+    AnytimeRun(const AnytimeRun&) = delete;
+    AnytimeRun& operator=(const AnytimeRun&) = delete;
+    void cancel(); // returns at once; the run stops after the iteration in progress
+    bool finished() const;
+    PathSnapshot best() const; // thread-safe copy of the latest snapshot
+    // Blocks until a snapshot newer than version is published, the run finishes or
+    // timeoutSeconds (< 0: no limit) pass, and returns the latest snapshot.
+    PathSnapshot waitForImprovement(int version, double timeoutSeconds = -1.0) const;
+    PathSnapshot wait() const; // until the run has finished, then its final snapshot
+
+private:
+    AnytimeRun(AntColonyBase& colony, double deadlineSeconds, const ImprovementCallback& onImprovement);
+    AntColonyBase& colony;
+    ImprovementCallback onImprovement;
+    mutable std::mutex mutex;
+    mutable std::condition_variable changed;
+    PathSnapshot snapshot; // guarded by mutex
+    bool done = false; // guarded by mutex
+    std::thread thread;
+    void publish(const ProgressInfo& info);
+};
+
+#endif
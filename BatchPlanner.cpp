@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "BatchPlanner.h"
+#include <chrono>
+#include <stdexcept>
+
+BatchPlanner::BatchPlanner(const GridMap& map, int threadCount, size_t distanceFields)
+    : map(map), distanceFields(distanceFields), heuristicTables(2 * distanceFields), pool(threadCount) {
+    // build the shared adjacency once up front instead of racing for it in the first queries
+    map.getNeighborTable(FourConnected::connectivity);
+}
+
+std::future<PlanResult> BatchPlanner::submit(const PlanQuery& query) {
+    return pool.submit([this, query] { return plan(query); });
+}
+
+std::vector<std::future<PlanResult>> BatchPlanner::submit(const std::vector<PlanQuery>& queries) {
+    std::vector<std::future<PlanResult>> results;
+    results.reserve(queries.size());
+    for (const PlanQuery& query : queries) {
+        results.push_back(submit(query));
+    }
+    return results;
+}
+
+PlanResult BatchPlanner::plan(const PlanQuery& query) {
+    auto passable = [this](std::pair<int, int> cell) {
+        return map.isInside(cell.first, cell.second) && !map.isObstacle(cell.first, cell.second);
+    };
+    if (!passable(query.start) || !passable(query.end)) {
+        throw std::invalid_argument("query start and goal must be free cells inside the map");
+    }
+    if (query.antCount < 1 || query.maxIterations < 1) {
+        throw std::invalid_argument("query needs at least one ant and one iteration");
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    int goalCell = map.cellId(query.end.first, query.end.second);
+    std::unique_ptr<AntColonyBase> colonyOwner;
+    if (query.geodesicHeuristic) {
+        colonyOwner.reset(new GeodesicAntColony(map, query.antCount, query.maxIterations, query.start, query.end));
+        colonyOwner->setHeuristicDistances(distanceFields);
+    }
+    else {
+        colonyOwner.reset(new AntColony(map, query.antCount, query.maxIterations, query.start, query.end));
+    }
+    colonyOwner->borrowHeuristicTable(heuristicTables);
+    AntColonyBase& colony = *colonyOwner;
+    colony.setSeed(query.seed);
+    colony.setPheromoneSettings(query.pheromoneSettings);
+    StoppingCriteria criteria;
+    criteria.timeBudgetSeconds = query.timeBudgetSeconds;
+    colony.setStoppingCriteria(criteria);
+    PlanResult result;
+    if (pheromoneCache) {
+        PheromoneField pheromones;
+        result.warmStarted = pheromoneCache->load(map, goalCell, pheromones);
+        if (result.warmStarted) colony.setPheromones(pheromones);
+    }
+    colony.run();
+    if (pheromoneCache && !colony.getBestPath().empty()) {
+        pheromoneCache->store(map, goalCell, colony.getPheromones());
+    }
+
+    for (int cell : colony.getBestPath()) {
+        result.path.push_back(map.cellPosition(cell));
+    }
+    result.pathLength = colony.getBestPathLength();
+    result.iterationsRun = colony.getIterationsRun();
+    result.antSteps = colony.getAntSteps();
+    result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return result;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef BATCHPLANNER_H
+#define BATCHPLANNER_H
+
+#include "AntColony.h"
+#include "DistanceField.h"
+#include "GridMap.h"
+#include "PheromoneCache.h"
+#include "WorkStealingPool.h"
+#include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
+
+// One start/goal query with its own budget.
+struct PlanQuery {
+    std::pair<int, int> start, end;
+    int antCount = 100;
+    int maxIterations = 10; // 迭代次数上限
+    double timeBudgetSeconds = 0.0; // wall-clock budget once the query starts running, 0 for none
+    uint64_t seed = 1;
+    PheromoneSettings pheromoneSettings;
+    bool geodesicHeuristic = false; // walking distances to the goal instead of straight lines, shared per goal
+};
+
+struct PlanResult {
+    std::vector<std::pair<int, int>> path; // start to end, empty if no ant arrived
+    double pathLength = -1.0;
+    int iterationsRun = 0;
+    long long antSteps = 0;
+    double elapsedSeconds = 0.0; // time spent running, not waiting in the queue
+    bool warmStarted = false; // started from a cached pheromone field
+};
+
+// Runs many queries against one map. The map is shared, not copied, and must
+// outlive the planner and stay unmodified while queries are pending. Each query
+// gets its own single-threaded colony; colonies are spread over a work-stealing pool.
+class BatchPlanner {
+public:
+    // distanceFields: goals whose distance fields are kept for geodesic queries;
+    // twice as many heuristic tables are kept, for either kind of query
+    BatchPlanner(const GridMap& map, int threadCount, size_t distanceFields = 16);
+    // An invalid start or goal makes the future throw std::invalid_argument.
+    std::future<PlanResult> submit(const PlanQuery& query);
+    std::vector<std::future<PlanResult>> submit(const std::vector<PlanQuery>& queries);
+    int getThreadCount() const { return pool.getThreadCount(); }
+    // Queries warm-start from and save their fields to cache; set before submitting.
+    void setPheromoneCache(PheromoneCache* cache) { pheromoneCache = cache; }
+
+private:
+    const GridMap& map;
+    PheromoneCache* pheromoneCache = nullptr;
+    DistanceFieldCache distanceFields;
+    HeuristicTableCache heuristicTables;
+    WorkStealingPool pool;
+    PlanResult plan(const PlanQuery& query);
+};
+
+#endif
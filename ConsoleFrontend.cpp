@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ConsoleFrontend.h"
+#include <iostream>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+ConsoleFrontend::ConsoleFrontend(bool showPheromones) : showPheromones(showPheromones) {}
+
+ConsoleFrontend::~ConsoleFrontend() {
+    if (cursorHidden) {
+        setCursorVisible(true);
+    }
+}
+
+void ConsoleFrontend::attach(AntColonyBase& colony, double minIntervalSeconds) {
+    colony.setProgressCallback([this](const ProgressInfo& info) { draw(info); }, minIntervalSeconds);
+}
+
+void ConsoleFrontend::draw(const ProgressInfo& info) {
+    if (!cursorHidden) {
+        setCursorVisible(false); // 设置光标不可见
+        cursorHidden = true;
+    }
+    progressBar(info.iteration, info.maxIterations, "Iteration", 50, 0);
+    if (showPheromones) {
+        std::cout << std::endl << "Iteration:" << info.iteration - 1 << std::endl;
+        info.colony->printPheromones();
+    }
+    if (info.finished) {
+        std::cout << std::endl;
+    }
+}
+
+void ConsoleFrontend::setCursorVisible(bool visible) {
+#ifdef _WIN32
+    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+    CONSOLE_CURSOR_INFO cursorInfo;
+    GetConsoleCursorInfo(hConsole, &cursorInfo);
+    cursorInfo.bVisible = visible;
+    SetConsoleCursorInfo(hConsole, &cursorInfo);
+#else
+    std::cout << (visible ? "\033[?25h" : "\033[?25l");
+#endif
+}
+
+void ConsoleFrontend::setCursorPosition(int x, int y) {
+    std::cout.flush();
+#ifdef _WIN32
+    static const HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    COORD coord = { (SHORT)x, (SHORT)y };
+    SetConsoleCursorPosition(hOut, coord);
+#else
+    std::cout << "\033[" << y + 1 << ";" << x + 1 << "H";
+#endif
+}
+
+void ConsoleFrontend::progressBar(int current, int total, const std::string& prefix, int barWidth, int posY) {
+    float progress = (float)current / total;
+    int pos = static_cast<int>(barWidth * progress);
+
+    setCursorPosition(0, posY);
+    std::cout << prefix << " [";
+
+    for (int i = 0; i < barWidth; ++i) {
+        if (i < pos) std::cout << "=";
+        else if (i == pos) std::cout << ">";
+        else std::cout << " ";
+    }
+
+    std::cout << "] " << current << "/" << total << "   "; // 多输出几个空格以覆盖旧的文本
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef CONSOLEFRONTEND_H
+#define CONSOLEFRONTEND_H
+
+#include "AntColony.h"
+#include <string>
+
+// Interactive console display on top of the progress callback: an iteration
+// progress bar and, optionally, the pheromone grid after every report.
+class ConsoleFrontend {
+public:
+    explicit ConsoleFrontend(bool showPheromones = true);
+    ~ConsoleFrontend();
+    void attach(AntColonyBase& colony, double minIntervalSeconds = 0.0);
+
+private:
+    bool showPheromones;
+    bool cursorHidden = false;
+    void draw(const ProgressInfo& info);
+    void setCursorVisible(bool visible);
+    void setCursorPosition(int x, int y);
+    void progressBar(int current, int total, const std::string& prefix, int barWidth, int posY);
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "DistanceField.h"
+#include "TransitionPolicy.h"
+#include <functional>
+#include <limits>
+#include <queue>
+
+std::vector<double> DistanceField::compute(const GridMap& map, int goal, int connectivity) {
+    const NeighborTable& neighbors = map.getNeighborTable(connectivity);
+    std::vector<double> distances(map.getCellCount(), std::numeric_limits<double>::infinity());
+    if (map.isObstacle(goal)) return distances;
+    distances[goal] = 0.0;
+    if (connectivity != 8) {
+        // 每步代价相同，广度优先即可
+        std::vector<int> queue(1, goal);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int cell = queue[head];
+            for (const int* next = neighbors.begin(cell); next != neighbors.end(cell); ++next) {
+                if (distances[*next] <= distances[cell] + 1.0) continue;
+                distances[*next] = distances[cell] + 1.0;
+                queue.push_back(*next);
+            }
+        }
+        return distances;
+    }
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    queue.push(Entry(0.0, goal));
+    while (!queue.empty()) {
+        Entry entry = queue.top();
+        queue.pop();
+        int cell = entry.second;
+        if (entry.first > distances[cell]) continue;
+        for (const int* next = neighbors.begin(cell); next != neighbors.end(cell); ++next) {
+            double distance = entry.first + EightConnected::stepCost(cell, *next, map.getWidth());
+            if (distance < distances[*next]) {
+                distances[*next] = distance;
+                queue.push(Entry(distance, *next));
+            }
+        }
+    }
+    return distances;
+}
+
+DistanceFieldCache::DistanceFieldCache(size_t capacity) : capacity(capacity) {}
+
+size_t DistanceFieldCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::shared_ptr<const std::vector<double>> DistanceFieldCache::get(const GridMap& map, int goalCell, int connectivity) {
+    Key key = { map.contentHash(), goalCell, connectivity == 8 ? 8 : 4 };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->second;
+        }
+    }
+    // computed without the lock; if two threads race, the first stored field wins
+    Field field = std::make_shared<const std::vector<double>>(DistanceField::compute(map, goalCell, key.connectivity));
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end()) return found->second->second;
+    if (capacity == 0) return field;
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(key, field);
+    index[key] = entries.begin();
+    return field;
+}
+
+HeuristicTableCache::HeuristicTableCache(size_t capacity) : capacity(capacity) {}
+
+size_t HeuristicTableCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+HeuristicTableCache::Table HeuristicTableCache::get(const GridMap& map, int goalCell, double beta, const std::string& heuristic,
+                                                    const std::function<std::vector<double>()>& build) {
+    Key key = { map.contentHash(), goalCell, beta, heuristic };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->second;
+        }
+    }
+    // built without the lock, like DistanceFieldCache::get
+    Table table = std::make_shared<const std::vector<double>>(build());
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end()) return found->second->second;
+    if (capacity == 0) return table;
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(key, table);
+    index[key] = entries.begin();
+    return table;
+}
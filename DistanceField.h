@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include "GridMap.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DistanceField {
+    // Shortest walking distance from every cell to goal over the map's 4- or
+    // 8-connected neighbor table (steps of 1, diagonals sqrt 2): breadth-first for
+    // 4, Dijkstra for 8. Obstacles and cells cut off from the goal are infinite.
+    // Meant for LookupTableHeuristic, see GeodesicAntColony.
+    std::vector<double> compute(const GridMap& map, int goal, int connectivity);
+}
+
+// Distance fields shared between colonies with the same goal, keyed by the map
+// contents, goal and connectivity; the most recently used ones are kept. Safe to
+// share between threads.
+class DistanceFieldCache {
+public:
+    explicit DistanceFieldCache(size_t capacity);
+    // Computes the field on the first request for this map, goal and connectivity.
+    std::shared_ptr<const std::vector<double>> get(const GridMap& map, int goalCell, int connectivity);
+    size_t size() const;
+
+private:
+    struct Key {
+        uint64_t mapHash;
+        int goalCell;
+        int connectivity;
+        bool operator==(const Key& other) const {
+            return mapHash == other.mapHash && goalCell == other.goalCell && connectivity == other.connectivity;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return (size_t)(key.mapHash ^ ((uint64_t)(key.goalCell * 2 + (key.connectivity == 8)) * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+    typedef std::shared_ptr<const std::vector<double>> Field;
+    typedef std::list<std::pair<Key, Field>> Entries;
+    size_t capacity;
+    Entries entries; // most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+    mutable std::mutex mutex;
+};
+
+// Heuristic tables, (1 / distance)^beta per cell as BasicAntColony builds them,
+// shared between colonies with the same goal (AntColonyBase::borrowHeuristicTable)
+// and keyed by the map contents, goal, beta and heuristic; the most recently used
+// ones are kept. Tables of LookupTableHeuristic colonies are only interchangeable
+// if their distances are, e.g. all from one DistanceFieldCache connectivity.
+// Safe to share between threads.
+class HeuristicTableCache {
+public:
+    typedef std::shared_ptr<const std::vector<double>> Table;
+    explicit HeuristicTableCache(size_t capacity);
+    // Calls build, without the lock, on the first request for this key.
+    Table get(const GridMap& map, int goalCell, double beta, const std::string& heuristic,
+              const std::function<std::vector<double>()>& build);
+    size_t size() const;
+
+private:
+    struct Key {
+        uint64_t mapHash;
+        int goalCell;
+        double beta;
+        std::string heuristic;
+        bool operator==(const Key& other) const {
+            return mapHash == other.mapHash && goalCell == other.goalCell && beta == other.beta && heuristic == other.heuristic;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return (size_t)(key.mapHash ^ ((uint64_t)key.goalCell * 0x9E3779B97F4A7C15ULL)) ^
+                   std::hash<double>()(key.beta) ^ std::hash<std::string>()(key.heuristic);
+        }
+    };
+    typedef std::list<std::pair<Key, Table>> Entries;
+    size_t capacity;
+    Entries entries; // most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+    mutable std::mutex mutex;
+};
+
+#endif
@@ -1,53 +1,448 @@
-/*
- * Copyright (c) 2024 Ch Oy @ NWPU
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#include "GridMap.h"
-#include <iostream>
-
-GridMap::GridMap(int width, int height) : width(width), height(height), grid(height, std::vector<bool>(width, false)) {}
-
-void GridMap::markObstacle(int x, int y) {
-    grid[y][x] = true;
-}
-
-void GridMap::markObstacles(const std::vector<std::pair<int, int>>& obstacles) {
-    for (const auto& obstacle : obstacles) {
-        markObstacle(obstacle.first, obstacle.second);
-    }
-}
-
-bool GridMap::isObstacle(int x, int y) const {
-    return grid[y][x];
-}
-
-void GridMap::printMap() const {
-    for (int y = height - 1; y >= 0; --y) {
-        for (int x = 0; x < width; ++x) {
-            std::cout << (grid[y][x] ? "X" : ".") << " ";
-        }
-        std::cout << std::endl;
-    }
-}
-
-int GridMap::getMaxSteps() const {
-    return (int)100;
-//    return width * height;
-}
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "GridMap.h"
+#include "MappedFile.h"
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    const char mapMagic[8] = { 'A', 'C', 'O', 'M', 'A', 'P', '1', 0 };
+
+    uint64_t mixBits(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // next header token of a PNM file, skipping whitespace and # comments
+    std::string readPnmToken(std::istream& in) {
+        std::string token;
+        int c;
+        while ((c = in.get()) != EOF) {
+            if (c == '#') {
+                while ((c = in.get()) != EOF && c != '\n') {}
+            }
+            else if (!isspace(c)) {
+                token += (char)c;
+                break;
+            }
+        }
+        while ((c = in.peek()) != EOF && !isspace(c) && c != '#') {
+            token += (char)in.get();
+        }
+        return token;
+    }
+}
+
+GridMap::GridMap(int width, int height) : width(width), height(height), words(((size_t)width * height + 63) / 64, 0) {}
+
+GridMap GridMap::loadPnm(const std::string& path, int threshold) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    std::string format = readPnmToken(in);
+    bool bitmap = format == "P1" || format == "P4";
+    bool binary = format == "P4" || format == "P5";
+    if (!bitmap && format != "P2" && format != "P5") throw std::runtime_error(path + ": not a PGM/PBM file");
+    int width = std::atoi(readPnmToken(in).c_str());
+    int height = std::atoi(readPnmToken(in).c_str());
+    int maxValue = bitmap ? 1 : std::atoi(readPnmToken(in).c_str());
+    if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535) throw std::runtime_error(path + ": bad header");
+    if (binary) in.get(); // the single whitespace before the raster
+
+    GridMap map(width, height);
+    int bytesPerSample = maxValue > 255 ? 2 : 1;
+    size_t rowBytes = format == "P4" ? (width + 7) / 8 : (size_t)width * bytesPerSample;
+    std::vector<unsigned char> row(binary ? rowBytes : 0);
+    for (int r = 0; r < height; ++r) {
+        int y = height - 1 - r;
+        if (binary && !in.read((char*)row.data(), rowBytes)) throw std::runtime_error(path + ": truncated raster");
+        for (int x = 0; x < width; ++x) {
+            bool obstacle;
+            if (format == "P4") {
+                obstacle = (row[x >> 3] >> (7 - (x & 7))) & 1;
+            }
+            else if (format == "P1") {
+                int c;
+                while ((c = in.get()) != EOF && c != '0' && c != '1') {
+                    if (c == '#') while ((c = in.get()) != EOF && c != '\n') {}
+                }
+                if (c == EOF) throw std::runtime_error(path + ": truncated raster");
+                obstacle = c == '1';
+            }
+            else {
+                int value;
+                if (binary) {
+                    value = bytesPerSample == 2 ? (row[2 * x] << 8) | row[2 * x + 1] : row[x];
+                }
+                else {
+                    std::string token = readPnmToken(in);
+                    if (token.empty()) throw std::runtime_error(path + ": truncated raster");
+                    value = std::atoi(token.c_str());
+                }
+                obstacle = value * 255 < threshold * maxValue;
+            }
+            if (obstacle) map.setObstacle(map.cellId(x, y), true);
+        }
+    }
+    return map;
+}
+
+GridMap GridMap::loadBinary(const std::string& path) {
+    std::shared_ptr<const MappedFile> file = std::make_shared<MappedFile>(path);
+    MapFileHeader header;
+    if (file->size() < sizeof(header)) throw std::runtime_error(path + ": not a map file");
+    std::memcpy(&header, file->data(), sizeof(header));
+    // cell ids are ints, and the payload must lie inside the file; compared without
+    // sums that a corrupt header could overflow
+    uint64_t cells = (uint64_t)header.width * header.height;
+    if (std::memcmp(header.magic, mapMagic, sizeof(mapMagic)) != 0 || header.dataOffset % 8 != 0 ||
+        cells > (uint64_t)INT_MAX || header.wordCount != (cells + 63) / 64 || header.dataOffset > file->size() ||
+        header.wordCount > (file->size() - header.dataOffset) / 8) {
+        throw std::runtime_error(path + ": not a map file");
+    }
+    GridMap map(0, 0);
+    map.width = header.width;
+    map.height = header.height;
+    map.mappedFile = file;
+    map.mappedWords = reinterpret_cast<const uint64_t*>(file->data() + header.dataOffset);
+    return map;
+}
+
+void GridMap::saveBinary(const std::string& path) const {
+    MapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, mapMagic, sizeof(mapMagic));
+    header.width = width;
+    header.height = height;
+    header.dataOffset = sizeof(header);
+    header.wordCount = ((uint64_t)width * height + 63) / 64;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(cellWords()), header.wordCount * sizeof(uint64_t));
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
+
+GridMap GridMap::downsample(int factor, double blockedFraction) const {
+    if (factor < 1) throw std::invalid_argument("downsample factor must be positive");
+    GridMap coarse((width + factor - 1) / factor, (height + factor - 1) / factor);
+    std::vector<int> blocked(coarse.getCellCount(), 0), children(coarse.getCellCount(), 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int parent = coarse.cellId(x / factor, y / factor);
+            ++children[parent];
+            blocked[parent] += isObstacle(x, y);
+        }
+    }
+    for (int cell = 0; cell < coarse.getCellCount(); ++cell) {
+        if (blocked[cell] > blockedFraction * children[cell]) coarse.setObstacle(cell, true);
+    }
+    return coarse;
+}
+
+GridMap GridMap::pruneDeadEnds(std::pair<int, int> start, std::pair<int, int> goal, int connectivity) const {
+    int directions = connectivity == 8 ? 8 : 4;
+    int startCell = cellId(start.first, start.second), goalCell = cellId(goal.first, goal.second);
+    GridMap pruned(*this);
+    int row[8];
+    auto deadEnd = [&](int cell) {
+        return cell != startCell && cell != goalCell && !pruned.isObstacle(cell) && pruned.neighborRow(cell, directions, row) <= 1;
+    };
+    std::vector<int> queue;
+    for (int cell = 0; cell < getCellCount(); ++cell) {
+        if (deadEnd(cell)) queue.push_back(cell);
+    }
+    // degrees only ever drop, so a queued cell is still a dead end when its turn comes
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        if (pruned.isObstacle(cell)) continue;
+        pruned.setObstacle(cell, true);
+        int x = cellX(cell), y = cellY(cell);
+        // the whole 3 x 3 window, as a new obstacle also blocks diagonals cutting its corners
+        for (int ny = y - 1; ny <= y + 1; ++ny) {
+            for (int nx = x - 1; nx <= x + 1; ++nx) {
+                if (isInside(nx, ny) && deadEnd(cellId(nx, ny))) queue.push_back(cellId(nx, ny));
+            }
+        }
+    }
+    return pruned;
+}
+
+CorridorTable GridMap::findCorridors(int connectivity, const std::vector<int>& keep) const {
+    const NeighborTable& table = getNeighborTable(connectivity);
+    const int ring = -2; // visited while building, not a corridor
+    CorridorTable corridors;
+    corridors.position.assign(getCellCount(), -1);
+    auto inCorridor = [&](int cell) {
+        return table.degree(cell) == 2 && std::find(keep.begin(), keep.end(), cell) == keep.end();
+    };
+    auto onwards = [&](int cell, int from) {
+        return table.begin(cell)[0] == from ? table.begin(cell)[1] : table.begin(cell)[0];
+    };
+    for (int cell = 0; cell < getCellCount(); ++cell) {
+        if (!inCorridor(cell) || corridors.position[cell] != -1) continue;
+        // back to one end of the chain, then along it to the other
+        int from = cell, end = table.begin(cell)[0];
+        while (end != cell && inCorridor(end)) {
+            int next = onwards(end, from);
+            from = end;
+            end = next;
+        }
+        if (end == cell) {
+            for (int at = cell, previous = from; corridors.position[at] != ring;) {
+                corridors.position[at] = ring;
+                int next = onwards(at, previous);
+                previous = at;
+                at = next;
+            }
+            continue;
+        }
+        corridors.cells.push_back(end);
+        int at = from;
+        from = end;
+        while (inCorridor(at)) {
+            corridors.position[at] = (int)corridors.cells.size();
+            corridors.cells.push_back(at);
+            int next = onwards(at, from);
+            from = at;
+            at = next;
+        }
+        corridors.cells.push_back(at);
+    }
+    for (int& position : corridors.position) {
+        if (position == ring) position = -1;
+    }
+    return corridors;
+}
+
+void GridMap::setObstacle(int cell, bool obstacle) {
+    setCellBit(cell, obstacle);
+    neighborsDirty[0] = neighborsDirty[1] = true;
+}
+
+void GridMap::setCellBit(int cell, bool obstacle) {
+    if (mappedWords) {
+        // 第一次修改时把映射的数据复制出来
+        size_t count = ((size_t)width * height + 63) / 64;
+        words.assign(mappedWords, mappedWords + count);
+        mappedWords = nullptr;
+        mappedFile.reset();
+    }
+    uint64_t bit = 1ULL << (cell & 63);
+    if (obstacle) words[cell >> 6] |= bit;
+    else words[cell >> 6] &= ~bit;
+    hashDirty = true;
+}
+
+std::vector<int> GridMap::applyChanges(const std::vector<std::pair<int, int>>& added, const std::vector<std::pair<int, int>>& removed) {
+    for (const auto& cells : { &added, &removed }) {
+        for (const auto& position : *cells) {
+            if (!isInside(position.first, position.second)) throw std::out_of_range("changed cell outside the map");
+        }
+    }
+    std::vector<int> changed;
+    for (const auto& position : added) {
+        int cell = cellId(position.first, position.second);
+        if (!isObstacle(cell)) {
+            setCellBit(cell, true);
+            changed.push_back(cell);
+        }
+    }
+    for (const auto& position : removed) {
+        int cell = cellId(position.first, position.second);
+        if (isObstacle(cell)) {
+            setCellBit(cell, false);
+            changed.push_back(cell);
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    if (changed.empty()) return changed;
+
+    std::vector<std::pair<int, MapChangeListener>> notify;
+    {
+        std::lock_guard<std::mutex> lock(tableLock.mutex);
+        // a cell's row depends on its 8 neighbors because diagonal moves may not cut corners
+        std::vector<int> rows;
+        for (int cell : changed) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (isInside(cellX(cell) + dx, cellY(cell) + dy)) rows.push_back(cellId(cellX(cell) + dx, cellY(cell) + dy));
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        if (!neighborsDirty[0]) patchNeighborTable(4, rows);
+        if (!neighborsDirty[1]) patchNeighborTable(8, rows);
+        notify = listeners.entries;
+    }
+    for (const auto& listener : notify) {
+        listener.second(changed);
+    }
+    return changed;
+}
+
+int GridMap::addChangeListener(const MapChangeListener& listener) const {
+    std::lock_guard<std::mutex> lock(tableLock.mutex);
+    listeners.entries.emplace_back(listeners.nextId, listener);
+    return listeners.nextId++;
+}
+
+void GridMap::removeChangeListener(int id) const {
+    std::lock_guard<std::mutex> lock(tableLock.mutex);
+    auto& entries = listeners.entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [id](const std::pair<int, MapChangeListener>& entry) { return entry.first == id; }), entries.end());
+}
+
+uint64_t GridMap::contentHash() const {
+    std::lock_guard<std::mutex> lock(tableLock.mutex);
+    if (hashDirty) {
+        // the bits past the last cell are always zero, so whole words can be hashed
+        uint64_t h = mixBits(((uint64_t)width << 32 | (uint32_t)height) + 0x9E3779B97F4A7C15ULL);
+        const uint64_t* bits = cellWords();
+        size_t count = ((size_t)width * height + 63) / 64;
+        for (size_t i = 0; i < count; ++i) {
+            h = mixBits(h ^ bits[i]) + 0x9E3779B97F4A7C15ULL;
+        }
+        hash = h;
+        hashDirty = false;
+    }
+    return hash;
+}
+
+void GridMap::markObstacle(int x, int y) {
+    setObstacle(cellId(x, y), true);
+}
+
+void GridMap::clearObstacle(int x, int y) {
+    setObstacle(cellId(x, y), false);
+}
+
+void GridMap::markObstacles(const std::vector<std::pair<int, int>>& obstacles) {
+    for (const auto& obstacle : obstacles) {
+        markObstacle(obstacle.first, obstacle.second);
+    }
+}
+
+void GridMap::printMap() const {
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            std::cout << (isObstacle(x, y) ? "X" : ".") << " ";
+        }
+        std::cout << std::endl;
+    }
+}
+
+const NeighborTable& GridMap::getNeighborTable(int connectivity) const {
+    int index = connectivity == 8 ? 1 : 0;
+    std::lock_guard<std::mutex> lock(tableLock.mutex);
+    if (neighborsDirty[index]) {
+        buildNeighborTable(connectivity);
+    }
+    return neighbors[index];
+}
+
+// Writes the neighbors of cell to row and returns how many there are.
+int GridMap::neighborRow(int cell, int directions, int* row) const {
+    // right, left, up, down, then the diagonals
+    static const int dx[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+    static const int dy[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+    if (isObstacle(cell)) return 0;
+    int x = cellX(cell), y = cellY(cell);
+    int count = 0;
+    for (int d = 0; d < directions; ++d) {
+        int nx = x + dx[d], ny = y + dy[d];
+        if (!isInside(nx, ny) || isObstacle(nx, ny)) continue;
+        // diagonal moves may not cut the corner of an obstacle
+        if (d >= 4 && (isObstacle(nx, y) || isObstacle(x, ny))) continue;
+        row[count++] = cellId(nx, ny);
+    }
+    return count;
+}
+
+void GridMap::buildNeighborTable(int connectivity) const {
+    int index = connectivity == 8 ? 1 : 0;
+    int directions = connectivity == 8 ? 8 : 4;
+    NeighborTable& table = neighbors[index];
+    int cellCount = getCellCount();
+    table.offsets.assign(cellCount + 1, 0);
+    // two passes: count the degrees, then fill, so ids is allocated exactly once
+    int row[8];
+    int total = 0;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        table.offsets[cell] = total;
+        total += neighborRow(cell, directions, row);
+    }
+    table.offsets[cellCount] = total;
+    table.ids.assign(total, 0);
+    table.ids.shrink_to_fit();
+    for (int cell = 0; cell < cellCount; ++cell) {
+        neighborRow(cell, directions, table.ids.data() + table.offsets[cell]);
+    }
+    neighborsDirty[index] = false;
+}
+
+// Recomputes the given rows (sorted cell ids). When no degree changes they are
+// overwritten in place, otherwise the untouched spans are moved around them.
+void GridMap::patchNeighborTable(int connectivity, const std::vector<int>& rows) const {
+    int directions = connectivity == 8 ? 8 : 4;
+    NeighborTable& table = neighbors[connectivity == 8 ? 1 : 0];
+    std::vector<int> rowIds(rows.size() * directions);
+    std::vector<int> degrees(rows.size());
+    bool sameDegrees = true;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        degrees[i] = neighborRow(rows[i], directions, &rowIds[i * directions]);
+        sameDegrees = sameDegrees && degrees[i] == table.degree(rows[i]);
+    }
+    if (sameDegrees) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            std::copy(&rowIds[i * directions], &rowIds[i * directions] + degrees[i], table.ids.begin() + table.offsets[rows[i]]);
+        }
+        return;
+    }
+    std::vector<int> ids;
+    ids.reserve(table.ids.size() + rows.size() * directions);
+    int shift = 0, next = 0, copied = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        int begin = table.offsets[rows[i]], end = table.offsets[rows[i] + 1];
+        ids.insert(ids.end(), table.ids.begin() + copied, table.ids.begin() + begin);
+        ids.insert(ids.end(), &rowIds[i * directions], &rowIds[i * directions] + degrees[i]);
+        copied = end;
+        for (; next <= rows[i]; ++next) table.offsets[next] += shift;
+        shift += degrees[i] - (end - begin);
+    }
+    ids.insert(ids.end(), table.ids.begin() + copied, table.ids.end());
+    for (; next <= getCellCount(); ++next) table.offsets[next] += shift;
+    table.ids.swap(ids);
+}
+
+int GridMap::getMaxSteps() const {
+    return (int)100;
+//    return width * height;
+}
@@ -1,44 +1,151 @@
-/*
- * Copyright (c) 2024 Ch Oy @ NWPU
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#pragma once
-#ifndef GRIDMAP_H
-#define GRIDMAP_H
-
-#include <vector>
-
-class GridMap {
-public:
-    GridMap(int width, int height);
-    void markObstacle(int x, int y);
-    void markObstacles(const std::vector<std::pair<int, int>>& obstacles);
-    bool isObstacle(int x, int y) const;
-    void printMap() const;
-    int getWidth() const { return width; }
-    int getHeight() const { return height; }
-    int getMaxSteps() const; 
-
-private:
-    int width, height;
-    std::vector<std::vector<bool>> grid;
-};
-
-#endif
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef GRIDMAP_H
+#define GRIDMAP_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MappedFile;
+
+// Native map file: this header followed, at dataOffset, by wordCount 64-bit
+// words holding one bit per cell in cell-id order (bit set = obstacle).
+struct MapFileHeader {
+    char magic[8]; // "ACOMAP1"
+    uint32_t width, height;
+    uint64_t dataOffset;
+    uint64_t wordCount;
+    uint32_t reserved[8];
+};
+
+// Compressed adjacency of passable cells: the neighbors of cell id c are
+// ids[offsets[c]] .. ids[offsets[c + 1] - 1]. Obstacle cells have no entries.
+struct NeighborTable {
+    std::vector<int> offsets;
+    std::vector<int> ids;
+    const int* begin(int cell) const { return ids.data() + offsets[cell]; }
+    const int* end(int cell) const { return ids.data() + offsets[cell + 1]; }
+    int degree(int cell) const { return offsets[cell + 1] - offsets[cell]; }
+};
+
+// Chains of corridor cells, passable cells with exactly two neighbors, stored
+// one after the other with the non-corridor cell at either end of each chain, so
+// from a corridor cell the cells of its chain continue in both directions up to
+// the next cell that is not a corridor cell. Ants that enter a chain follow it
+// without a decision per cell.
+struct CorridorTable {
+    std::vector<int> cells;
+    std::vector<int> position; // per cell id, its index in cells, -1 unless it is a corridor cell
+    bool isCorridor(int cell) const { return position[cell] >= 0; }
+};
+
+// Called by GridMap::applyChanges with the ids of the cells that changed state.
+typedef std::function<void(const std::vector<int>& changedCells)> MapChangeListener;
+
+// Cells are stored row-major, one bit each; a cell id is y * width + x.
+class GridMap {
+public:
+    GridMap(int width, int height);
+    // PGM (P2/P5) or PBM (P1/P4), streamed row by row. Image row 0 is the top
+    // of the map; a PGM pixel darker than threshold (on a 0..255 scale) is an obstacle.
+    static GridMap loadPnm(const std::string& path, int threshold = 128);
+    // Native format, memory-mapped and used in place until the map is modified.
+    static GridMap loadBinary(const std::string& path);
+    void saveBinary(const std::string& path) const;
+    // Coarser map where cell (x, y) covers the factor x factor block starting at
+    // (x * factor, y * factor). With the default of 0 a coarse cell is blocked if
+    // any cell of its block is; otherwise if more than blockedFraction of them are.
+    GridMap downsample(int factor, double blockedFraction = 0.0) const;
+    // Copy in which dead ends are obstacles: passable cells with at most one
+    // neighbor are filled until none is left, except start and goal, which removes
+    // cul-de-sacs that no path between them can use. Linear in the cell count.
+    GridMap pruneDeadEnds(std::pair<int, int> start, std::pair<int, int> goal, int connectivity = 4) const;
+    // Corridors of the current layout; the cells in keep (e.g. start and goal) are
+    // never part of one. Rings without any other cell are left out.
+    CorridorTable findCorridors(int connectivity, const std::vector<int>& keep) const;
+    void markObstacle(int x, int y);
+    void clearObstacle(int x, int y);
+    void markObstacles(const std::vector<std::pair<int, int>>& obstacles);
+    // Live update: unlike markObstacle / clearObstacle this patches the rows of the
+    // neighbor tables already built and notifies the listeners. removed is applied
+    // after added. Returns the ids of the cells whose state changed.
+    std::vector<int> applyChanges(const std::vector<std::pair<int, int>>& added, const std::vector<std::pair<int, int>>& removed);
+    // Listening does not modify the map, so a const map accepts listeners; copies start without any.
+    int addChangeListener(const MapChangeListener& listener) const;
+    void removeChangeListener(int id) const;
+    bool isObstacle(int x, int y) const { return isObstacle(cellId(x, y)); }
+    bool isObstacle(int cell) const { return (cellWords()[cell >> 6] >> (cell & 63)) & 1; }
+    bool isInside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    void printMap() const;
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getCellCount() const { return width * height; }
+    int cellId(int x, int y) const { return y * width + x; }
+    int cellX(int cell) const { return cell % width; }
+    int cellY(int cell) const { return cell / width; }
+    std::pair<int, int> cellPosition(int cell) const { return { cellX(cell), cellY(cell) }; }
+    // 4 or 8, built on first use after the map changes; safe to call from several
+    // threads as long as nobody modifies the map meanwhile
+    const NeighborTable& getNeighborTable(int connectivity = 4) const;
+    int getMaxSteps() const; 
+    uint64_t contentHash() const; // of the size and obstacle layout, cached until the map changes
+
+private:
+    int width, height;
+    std::vector<uint64_t> words; // cell bits, unless the map is backed by a file
+    std::shared_ptr<const MappedFile> mappedFile; // read-only, shared between copies
+    const uint64_t* mappedWords = nullptr;
+    const uint64_t* cellWords() const { return mappedWords ? mappedWords : words.data(); }
+    void setObstacle(int cell, bool obstacle);
+    void setCellBit(int cell, bool obstacle);
+    mutable NeighborTable neighbors[2]; // 4- and 8-connected
+    mutable bool neighborsDirty[2] = { true, true };
+    // guards the lazy build; every copy of the map gets its own
+    struct TableLock {
+        std::mutex mutex;
+        TableLock() {}
+        TableLock(const TableLock&) {}
+        TableLock& operator=(const TableLock&) { return *this; }
+    };
+    mutable TableLock tableLock;
+    struct ListenerList {
+        std::vector<std::pair<int, MapChangeListener>> entries;
+        int nextId = 0;
+        ListenerList() {}
+        ListenerList(const ListenerList&) {}
+        ListenerList& operator=(const ListenerList&) { return *this; }
+    };
+    mutable ListenerList listeners; // guarded by tableLock
+    mutable uint64_t hash = 0;
+    mutable bool hashDirty = true;
+    void buildNeighborTable(int connectivity) const;
+    int neighborRow(int cell, int directions, int* row) const;
+    void patchNeighborTable(int connectivity, const std::vector<int>& rows) const;
+};
+
+#endif
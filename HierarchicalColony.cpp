@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "HierarchicalColony.h"
+#include <algorithm>
+#include <stdexcept>
+
+HierarchicalColony::HierarchicalColony(const GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end)
+    : map(map), antCount(antCount), maxIterations(maxIterations), start(start), end(end) {}
+
+void HierarchicalColony::setSettings(const HierarchySettings& value) {
+    if (value.levels < 0 || value.coarsestSize < 1 || value.factor < 2 || value.bandRadius < 0 || value.segmentCells < 1 ||
+        value.blockedFraction < 0.0 || value.blockedFraction >= 1.0) {
+        throw std::invalid_argument("invalid hierarchy settings");
+    }
+    settings = value;
+}
+
+void HierarchicalColony::setThreadCount(int count) {
+    threadCount = count;
+}
+
+void HierarchicalColony::setSeed(uint64_t value) {
+    seed = value;
+}
+
+void HierarchicalColony::setPheromoneSettings(const PheromoneSettings& value) {
+    pheromoneSettings = value;
+}
+
+// Runs one colony from -> to (cell ids of level) on the window [x0, x1) x [y0, y1) of
+// level, with the window cells not set in keep blocked (null keeps them all). The path
+// is appended to path as cell ids of level, and the final field, if wanted, merged
+// into levelPheromones.
+bool HierarchicalColony::solveWindow(const GridMap& level, int x0, int y0, int x1, int y1, const std::vector<unsigned char>* keep,
+                                     const std::vector<double>* initialPheromones, int from, int to,
+                                     std::vector<int>& path, double& length, std::vector<double>* levelPheromones) {
+    GridMap window(x1 - x0, y1 - y0);
+    for (int y = 0; y < window.getHeight(); ++y) {
+        for (int x = 0; x < window.getWidth(); ++x) {
+            if (level.isObstacle(x0 + x, y0 + y) || (keep && !(*keep)[window.cellId(x, y)])) window.markObstacle(x, y);
+        }
+    }
+    std::pair<int, int> windowStart(level.cellX(from) - x0, level.cellY(from) - y0);
+    std::pair<int, int> windowEnd(level.cellX(to) - x0, level.cellY(to) - y0);
+    // 粗层上起点和终点所在的格子可能被判为障碍
+    window.clearObstacle(windowStart.first, windowStart.second);
+    window.clearObstacle(windowEnd.first, windowEnd.second);
+    AntColony colony(window, antCount, maxIterations, windowStart, windowEnd);
+    colony.setThreadCount(threadCount);
+    colony.setSeed(seed + colonies++);
+    colony.setPheromoneSettings(pheromoneSettings);
+    if (initialPheromones) colony.setPheromones(*initialPheromones);
+    colony.run();
+    iterationsRun += colony.getIterationsRun();
+    antSteps += colony.getAntSteps();
+    if (colony.getBestPath().empty()) return false;
+    for (int cell : colony.getBestPath()) {
+        path.push_back(level.cellId(x0 + window.cellX(cell), y0 + window.cellY(cell)));
+    }
+    length = colony.getBestPathLength();
+    if (levelPheromones) {
+        const PheromoneField& pheromones = colony.getPheromones();
+        for (int cell = 0; cell < window.getCellCount(); ++cell) {
+            double& value = (*levelPheromones)[level.cellId(x0 + window.cellX(cell), y0 + window.cellY(cell))];
+            value = std::max(value, pheromones.value(cell));
+        }
+    }
+    return true;
+}
+
+// Solves from -> to within radius cells of the blocks of level covered by coarseCells.
+bool HierarchicalColony::solveSegment(const GridMap& level, const GridMap& coarse, const std::vector<double>& coarsePheromones,
+                                      const int* coarseCells, int count, int radius, int from, int to,
+                                      std::vector<int>& path, double& length, std::vector<double>* levelPheromones) {
+    int factor = settings.factor;
+    int x0 = level.getWidth(), y0 = level.getHeight(), x1 = 0, y1 = 0;
+    for (int i = 0; i < count; ++i) {
+        x0 = std::min(x0, std::max(0, coarse.cellX(coarseCells[i]) * factor - radius));
+        y0 = std::min(y0, std::max(0, coarse.cellY(coarseCells[i]) * factor - radius));
+        x1 = std::max(x1, std::min(level.getWidth(), (coarse.cellX(coarseCells[i]) + 1) * factor + radius));
+        y1 = std::max(y1, std::min(level.getHeight(), (coarse.cellY(coarseCells[i]) + 1) * factor + radius));
+    }
+    int width = x1 - x0, height = y1 - y0;
+    std::vector<unsigned char> keep((size_t)width * height, 0);
+    for (int i = 0; i < count; ++i) {
+        int bx0 = std::max(x0, coarse.cellX(coarseCells[i]) * factor - radius);
+        int bx1 = std::min(x1, (coarse.cellX(coarseCells[i]) + 1) * factor + radius);
+        int by0 = std::max(y0, coarse.cellY(coarseCells[i]) * factor - radius);
+        int by1 = std::min(y1, (coarse.cellY(coarseCells[i]) + 1) * factor + radius);
+        for (int y = by0; y < by1; ++y) {
+            std::fill(keep.begin() + (size_t)(y - y0) * width + (bx0 - x0), keep.begin() + (size_t)(y - y0) * width + (bx1 - x0), 1);
+        }
+    }
+    // project the coarse field: 1 + biasStrength * value / strongest value under the window
+    std::vector<double> pheromones((size_t)width * height, 1.0);
+    double strongest = 0.0;
+    for (int y = y0; y < y1; y += factor) {
+        for (int x = x0; x < x1; x += factor) {
+            strongest = std::max(strongest, coarsePheromones[coarse.cellId(x / factor, y / factor)]);
+        }
+    }
+    if (strongest > 0.0) {
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                double value = coarsePheromones[coarse.cellId(x / factor, y / factor)];
+                pheromones[(size_t)(y - y0) * width + (x - x0)] += settings.biasStrength * value / strongest;
+            }
+        }
+    }
+    return solveWindow(level, x0, y0, x1, y1, &keep, &pheromones, from, to, path, length, levelPheromones);
+}
+
+// The free cell of the block under coarseCell closest to the block's center, -1 if there is none.
+int HierarchicalColony::waypointInBlock(const GridMap& level, const GridMap& coarse, int coarseCell) const {
+    int factor = settings.factor;
+    int bx = coarse.cellX(coarseCell) * factor, by = coarse.cellY(coarseCell) * factor;
+    int cx = bx + factor / 2, cy = by + factor / 2;
+    int best = -1, bestDistance = 0;
+    for (int y = by; y < std::min(by + factor, level.getHeight()); ++y) {
+        for (int x = bx; x < std::min(bx + factor, level.getWidth()); ++x) {
+            int distance = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+            if (!level.isObstacle(x, y) && (best < 0 || distance < bestDistance)) {
+                best = level.cellId(x, y);
+                bestDistance = distance;
+            }
+        }
+    }
+    return best;
+}
+
+void HierarchicalColony::run() {
+    iterationsRun = 0;
+    antSteps = 0;
+    colonies = 0;
+    bestPath.clear();
+    // pyramid[k] is level k + 1; level 0 is the map itself
+    std::vector<GridMap> pyramid;
+    auto levelMap = [&](int level) -> const GridMap& { return level == 0 ? map : pyramid[level - 1]; };
+    int levels = 1;
+    while (settings.levels > 0 ? levels < settings.levels
+                               : std::max(levelMap(levels - 1).getWidth(), levelMap(levels - 1).getHeight()) > settings.coarsestSize) {
+        pyramid.push_back(levelMap(levels - 1).downsample(settings.factor, settings.blockedFraction));
+        ++levels;
+    }
+    int scale = 1;
+    for (int level = 1; level < levels; ++level) scale *= settings.factor;
+    auto cellOf = [&](const GridMap& level, std::pair<int, int> position) {
+        return level.cellId(position.first / scale, position.second / scale);
+    };
+
+    const GridMap& top = levelMap(levels - 1);
+    std::vector<int> coarsePath;
+    std::vector<double> coarsePheromones(levels > 1 ? top.getCellCount() : 0, 0.0);
+    double length = 0.0;
+    if (!solveWindow(top, 0, 0, top.getWidth(), top.getHeight(), nullptr, nullptr, cellOf(top, start), cellOf(top, end),
+                     coarsePath, length, levels > 1 ? &coarsePheromones : nullptr)) {
+        return;
+    }
+    for (int level = levels - 2; level >= 0; --level) {
+        scale /= settings.factor;
+        const GridMap& fine = levelMap(level);
+        const GridMap& coarse = levelMap(level + 1);
+        std::vector<double> finePheromones(level > 0 ? fine.getCellCount() : 0, 0.0);
+        std::vector<int> finePath;
+        int from = cellOf(fine, start), goal = cellOf(fine, end);
+        int size = (int)coarsePath.size();
+        int first = 0;
+        length = 0.0;
+        // 沿粗层路径每隔 segmentCells 个格子设一个路标，逐段求解
+        do {
+            int last = std::min(first + settings.segmentCells, size - 1);
+            int to = -1;
+            while (last < size - 1 && (to = waypointInBlock(fine, coarse, coarsePath[last])) < 0) ++last;
+            if (last == size - 1) to = goal;
+            std::vector<int> segment(1, from);
+            double segmentLength = 0.0;
+            if (from != to) {
+                segment.clear();
+                std::vector<double>* pheromones = level > 0 ? &finePheromones : nullptr;
+                bool found = solveSegment(fine, coarse, coarsePheromones, &coarsePath[first], last - first + 1,
+                                          settings.bandRadius, from, to, segment, segmentLength, pheromones) ||
+                             solveSegment(fine, coarse, coarsePheromones, &coarsePath[first], last - first + 1,
+                                          4 * settings.bandRadius + settings.factor, from, to, segment, segmentLength, pheromones);
+                if (!found) return;
+            }
+            // consecutive segments share their waypoint
+            finePath.insert(finePath.end(), segment.begin() + (finePath.empty() ? 0 : 1), segment.end());
+            length += segmentLength;
+            from = to;
+            first = last;
+        } while (first < size - 1);
+        coarsePath.swap(finePath);
+        coarsePheromones.swap(finePheromones);
+    }
+    bestPath.swap(coarsePath);
+    bestPathLength = length;
+}
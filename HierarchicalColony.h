@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef HIERARCHICALCOLONY_H
+#define HIERARCHICALCOLONY_H
+
+#include "AntColony.h"
+#include "GridMap.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct HierarchySettings {
+    int levels = 0; // including the full map; 0 adds levels until the coarsest fits in coarsestSize
+    int coarsestSize = 32; // cells per side
+    int factor = 4; // cells per side merged into one cell of the next coarser level
+    // a coarse cell is blocked when more than this share of its cells are, 0 for any
+    double blockedFraction = 0.5;
+    int bandRadius = 8; // cells kept on either side of the coarse path's projection
+    int segmentCells = 8; // coarse path cells between two waypoints on the finer level
+    double biasStrength = 4.0; // initial pheromone added where the coarse field is strongest
+};
+
+// Coarse-to-fine solver for large maps, where the heuristic is too flat for ants
+// to find a distant goal. The map is downsampled (see GridMap::downsample) and the
+// coarsest level solved directly. On each finer level the coarse path is cut into
+// segments of segmentCells cells; every segment is solved by its own colony on a
+// window of the map confined to a band around the segment's blocks, starting from
+// 1 + biasStrength * (normalized coarse pheromone). A segment without a path is
+// retried once with a band four times as wide before the level gives up.
+class HierarchicalColony {
+public:
+    HierarchicalColony(const GridMap& map, int antCount, int maxIterations, std::pair<int, int> start, std::pair<int, int> end);
+    void setSettings(const HierarchySettings& settings);
+    void setThreadCount(int threadCount);
+    void setSeed(uint64_t seed);
+    void setPheromoneSettings(const PheromoneSettings& settings);
+    void run();
+    int getIterationsRun() const { return iterationsRun; } // over all colonies
+    long long getAntSteps() const { return antSteps; }
+    double getBestPathLength() const { return bestPath.empty() ? -1.0 : bestPathLength; }
+    const std::vector<int>& getBestPath() const { return bestPath; } // cell ids of the full map
+
+private:
+    const GridMap& map;
+    int antCount, maxIterations;
+    std::pair<int, int> start, end;
+    HierarchySettings settings;
+    int threadCount = 1;
+    uint64_t seed = 1;
+    PheromoneSettings pheromoneSettings;
+    int iterationsRun = 0;
+    long long antSteps = 0;
+    std::vector<int> bestPath;
+    double bestPathLength = 0.0;
+    int colonies = 0; // solved so far in this run, varies the seed
+    bool solveWindow(const GridMap& level, int x0, int y0, int x1, int y1, const std::vector<unsigned char>* keep,
+                     const std::vector<double>* initialPheromones, int from, int to,
+                     std::vector<int>& path, double& length, std::vector<double>* levelPheromones);
+    bool solveSegment(const GridMap& level, const GridMap& coarse, const std::vector<double>& coarsePheromones,
+                      const int* coarseCells, int count, int radius, int from, int to,
+                      std::vector<int>& path, double& length, std::vector<double>* levelPheromones);
+    int waypointInBlock(const GridMap& level, const GridMap& coarse, int coarseCell) const;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "IslandColony.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <stdexcept>
+
+IslandColony::IslandColony(const GridMap& map, const std::vector<IslandSettings>& islands, int maxIterations,
+                           std::pair<int, int> start, std::pair<int, int> end)
+    : map(map), islands(islands), maxIterations(maxIterations), start(start), end(end) {
+    if (islands.empty()) {
+        throw std::invalid_argument("an island colony needs at least one island");
+    }
+}
+
+void IslandColony::setMigrationSettings(const MigrationSettings& value) {
+    if (value.interval < 0 || value.blendWeight < 0.0 || value.blendWeight > 1.0) {
+        throw std::invalid_argument("invalid migration settings");
+    }
+    migration = value;
+}
+
+void IslandColony::setThreadCount(int count) {
+    threadCount = count;
+}
+
+void IslandColony::setSeed(uint64_t value) {
+    seed = value;
+}
+
+int IslandColony::bestIsland() const {
+    int best = -1;
+    for (int i = 0; i < (int)colonies.size(); ++i) {
+        double length = colonies[i]->getBestPathLength();
+        if (length >= 0.0 && (best < 0 || length < colonies[best]->getBestPathLength())) best = i;
+    }
+    return best;
+}
+
+int IslandColony::sourceOf(int island, int best) const {
+    int count = (int)colonies.size();
+    return migration.topology == MigrationTopology::Ring ? (island + count - 1) % count : best;
+}
+
+// Sources are read from copies taken before any island changes, so the order of
+// the islands does not matter.
+void IslandColony::migrate() {
+    int count = (int)colonies.size();
+    int best = bestIsland();
+    if (migration.mode == MigrationMode::BestPath) {
+        for (int i = 0; i < count; ++i) {
+            migrantPaths[i] = colonies[i]->getBestPath();
+        }
+        for (int i = 0; i < count; ++i) {
+            int source = sourceOf(i, best);
+            if (source >= 0 && source != i && !migrantPaths[source].empty()) colonies[i]->acceptPath(migrantPaths[source]);
+        }
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        migrantFields[i] = colonies[i]->getPheromones();
+    }
+    double weight = migration.blendWeight;
+    for (int i = 0; i < count; ++i) {
+        int source = sourceOf(i, best);
+        if (source < 0 || source == i) continue;
+        blended = migrantFields[i];
+        blended.blend(migrantFields[source], weight);
+        colonies[i]->setPheromones(blended);
+    }
+}
+
+// 每轮各岛并行迭代 interval 次，然后迁移. Each island is one run resumed round
+// after round, so iteration numbers (MaxMin's best-so-far deposits), stall counts
+// and counters span the whole run.
+void IslandColony::run() {
+    int count = (int)islands.size();
+    colonies.clear();
+    for (const IslandSettings& island : islands) {
+        colonies.emplace_back(new TunableAntColony(map, island.antCount, maxIterations, start, end));
+        colonies.back()->setSeed(seed + colonies.size() - 1);
+        colonies.back()->setExponents(island.alpha, island.beta);
+        colonies.back()->setEvaporationRate(island.evaporationRate);
+        colonies.back()->setPheromoneSettings(island.pheromoneSettings);
+    }
+    migrantPaths.resize(count);
+    migrantFields.resize(count);
+    iterationsRun = 0;
+    antSteps = 0;
+    ThreadPool pool(threadCount > 0 ? std::min(threadCount, count) : count);
+    int interval = migration.interval > 0 ? migration.interval : maxIterations;
+    std::vector<char> paused(count, 1);
+    while (true) {
+        pool.parallelFor(count, [&](int i) {
+            if (paused[i]) paused[i] = colonies[i]->resume(interval);
+        });
+        if (std::find(paused.begin(), paused.end(), 1) == paused.end()) break;
+        migrate();
+    }
+    for (const auto& colony : colonies) {
+        iterationsRun += colony->getIterationsRun();
+        antSteps += colony->getAntSteps();
+    }
+    int best = bestIsland();
+    bestPath = best >= 0 ? colonies[best]->getBestPath() : std::vector<int>();
+    bestPathLength = best >= 0 ? colonies[best]->getBestPathLength() : 0.0;
+}
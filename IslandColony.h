@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef ISLANDCOLONY_H
+#define ISLANDCOLONY_H
+
+#include "AntColony.h"
+#include "GridMap.h"
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Parameters of one island; each island runs its own colony with its own field.
+struct IslandSettings {
+    int antCount = 100;
+    double alpha = 1.0;
+    double beta = 3.0;
+    double evaporationRate = 0.3;
+    PheromoneSettings pheromoneSettings;
+};
+
+enum class MigrationMode {
+    BestPath,       // the source's best path is deposited once and kept if shorter
+    BlendPheromones // the field moves blendWeight of the way towards the source's field
+};
+
+enum class MigrationTopology {
+    Ring,     // island i receives from island i - 1
+    Broadcast // every island receives from the one with the shortest best path
+};
+
+struct MigrationSettings {
+    int interval = 5; // iterations between migrations, 0 never migrates
+    MigrationMode mode = MigrationMode::BestPath;
+    MigrationTopology topology = MigrationTopology::Ring;
+    double blendWeight = 0.1; // BlendPheromones, in [0, 1]
+};
+
+// Island model: several independent colonies (TunableAntColony) on the same map,
+// one thread each, which run interval iterations at a time and then exchange
+// their best paths or pheromone fields. Extra cores go to solution quality: the
+// islands search with different parameters and seeds instead of one colony with
+// more ants, which stagnates just the same. Results only depend on the seed.
+class IslandColony {
+public:
+    IslandColony(const GridMap& map, const std::vector<IslandSettings>& islands, int maxIterations,
+                 std::pair<int, int> start, std::pair<int, int> end);
+    void setMigrationSettings(const MigrationSettings& settings);
+    void setThreadCount(int threadCount); // islands run concurrently, 0 for one thread per island
+    void setSeed(uint64_t seed);
+    void run();
+    int getIterationsRun() const { return iterationsRun; } // over all islands
+    long long getAntSteps() const { return antSteps; }
+    double getBestPathLength() const { return bestPath.empty() ? -1.0 : bestPathLength; }
+    const std::vector<int>& getBestPath() const { return bestPath; }
+    int getIslandCount() const { return (int)islands.size(); }
+    const AntColonyBase& getIsland(int index) const { return *colonies.at(index); } // after run()
+
+private:
+    const GridMap& map;
+    std::vector<IslandSettings> islands;
+    int maxIterations;
+    std::pair<int, int> start, end;
+    MigrationSettings migration;
+    int threadCount = 0;
+    uint64_t seed = 1;
+    int iterationsRun = 0;
+    long long antSteps = 0;
+    std::vector<int> bestPath;
+    double bestPathLength = 0.0;
+    std::vector<std::unique_ptr<TunableAntColony>> colonies;
+    std::vector<std::vector<int>> migrantPaths; // per island, reused between migrations
+    std::vector<PheromoneField> migrantFields;
+    PheromoneField blended;
+    int bestIsland() const; // -1 while no island has a path
+    int sourceOf(int island, int best) const;
+    void migrate();
+};
+
+#endif
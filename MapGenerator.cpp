@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "MapGenerator.h"
+#include "Random.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    int randomInt(Random& random, int bound) {
+        return (int)(random.next() % (uint64_t)bound);
+    }
+
+    void clearCell(GridMap& map, std::pair<int, int> cell) {
+        map.clearObstacle(cell.first, cell.second);
+    }
+}
+
+GeneratedMap MapGenerator::randomObstacles(int width, int height, double density, uint64_t seed) {
+    GeneratedMap result = { GridMap(width, height), { 0, 0 }, { width - 1, height - 1 } };
+    Random random(seed);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (random.nextDouble() < density) {
+                result.map.markObstacle(x, y);
+            }
+        }
+    }
+    clearCell(result.map, result.start);
+    clearCell(result.map, result.goal);
+    return result;
+}
+
+GeneratedMap MapGenerator::maze(int width, int height, uint64_t seed) {
+    // passages on even coordinates, walls carved between them
+    int cellsX = (width + 1) / 2, cellsY = (height + 1) / 2;
+    GeneratedMap result = { GridMap(width, height), { 0, 0 }, { (cellsX - 1) * 2, (cellsY - 1) * 2 } };
+    GridMap& map = result.map;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            map.markObstacle(x, y);
+        }
+    }
+    Random random(seed);
+    std::vector<unsigned char> visited((size_t)cellsX * cellsY, 0);
+    std::vector<int> stack(1, 0);
+    visited[0] = 1;
+    map.clearObstacle(0, 0);
+    const int dx[4] = { 1, -1, 0, 0 };
+    const int dy[4] = { 0, 0, 1, -1 };
+    while (!stack.empty()) {
+        int cell = stack.back();
+        int cx = cell % cellsX, cy = cell / cellsX;
+        int options[4], count = 0;
+        for (int d = 0; d < 4; ++d) {
+            int nx = cx + dx[d], ny = cy + dy[d];
+            if (nx >= 0 && nx < cellsX && ny >= 0 && ny < cellsY && !visited[(size_t)ny * cellsX + nx]) {
+                options[count++] = d;
+            }
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        int d = options[randomInt(random, count)];
+        int nx = cx + dx[d], ny = cy + dy[d];
+        map.clearObstacle(cx * 2 + dx[d], cy * 2 + dy[d]);
+        map.clearObstacle(nx * 2, ny * 2);
+        visited[(size_t)ny * cellsX + nx] = 1;
+        stack.push_back(ny * cellsX + nx);
+    }
+    return result;
+}
+
+GeneratedMap MapGenerator::corridors(int width, int height, int spacing, uint64_t seed) {
+    GeneratedMap result = { GridMap(width, height), { 0, 0 }, { width - 1, height - 1 } };
+    Random random(seed);
+    if (spacing < 2) spacing = 2;
+    for (int y = spacing; y < height - 1; y += spacing) {
+        int gap = randomInt(random, width);
+        for (int x = 0; x < width; ++x) {
+            if (x != gap) result.map.markObstacle(x, y);
+        }
+    }
+    clearCell(result.map, result.start);
+    clearCell(result.map, result.goal);
+    return result;
+}
+
+GeneratedMap MapGenerator::rooms(int width, int height, int roomSize, uint64_t seed) {
+    GeneratedMap result = { GridMap(width, height), { 0, 0 }, { width - 1, height - 1 } };
+    GridMap& map = result.map;
+    Random random(seed);
+    if (roomSize < 2) roomSize = 2;
+    int step = roomSize + 1;
+    // vertical walls, one door per room along each wall
+    for (int x = roomSize; x < width - 1; x += step) {
+        for (int top = 0; top < height; top += step) {
+            int door = top + randomInt(random, std::min(roomSize, height - top));
+            for (int y = top; y < top + step && y < height; ++y) {
+                if (y != door) map.markObstacle(x, y);
+            }
+        }
+    }
+    // horizontal walls
+    for (int y = roomSize; y < height - 1; y += step) {
+        for (int left = 0; left < width; left += step) {
+            int door = left + randomInt(random, std::min(roomSize, width - left));
+            for (int x = left; x < left + step && x < width; ++x) {
+                if (x != door) map.markObstacle(x, y);
+            }
+        }
+    }
+    clearCell(map, result.start);
+    clearCell(map, result.goal);
+    return result;
+}
+
+GeneratedMap MapGenerator::generate(const std::string& kind, int width, int height, uint64_t seed) {
+    if (kind == "random") return randomObstacles(width, height, 0.2, seed);
+    if (kind == "maze") return maze(width, height, seed);
+    if (kind == "corridors") return corridors(width, height, 4, seed);
+    if (kind == "rooms") return rooms(width, height, 8, seed);
+    throw std::invalid_argument("unknown map kind: " + kind);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef MAPGENERATOR_H
+#define MAPGENERATOR_H
+
+#include "GridMap.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// A synthetic map with free start and goal cells near opposite corners.
+struct GeneratedMap {
+    GridMap map;
+    std::pair<int, int> start, goal;
+};
+
+// Reproducible map generators: the same arguments always give the same map.
+namespace MapGenerator {
+    // independent obstacles with the given density; start and goal are kept free
+    GeneratedMap randomObstacles(int width, int height, double density, uint64_t seed);
+    // perfect maze carved by a randomized depth-first search on a 2-cell lattice
+    GeneratedMap maze(int width, int height, uint64_t seed);
+    // horizontal walls every `spacing` rows, each with one gap at a random column
+    GeneratedMap corridors(int width, int height, int spacing, uint64_t seed);
+    // rooms of roomSize cells separated by walls with one random door per wall
+    GeneratedMap rooms(int width, int height, int roomSize, uint64_t seed);
+    // "random", "maze", "corridors" or "rooms" with default parameters
+    GeneratedMap generate(const std::string& kind, int width, int height, uint64_t seed);
+}
+
+#endif
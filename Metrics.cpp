@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Metrics.h"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+    const char* const phaseNames[PhaseCount] = { "construction", "collection", "evaporation", "deposit", "telemetry" };
+
+    struct CounterInfo {
+        const char* name;
+        const char* help;
+    };
+
+    const CounterInfo counterInfo[CounterCount] = {
+        { "iterations", "Iterations completed." },
+        { "ant_steps", "Moves made by all ants, including backtracking." },
+        { "arrived_ants", "Ants that reached the goal." },
+        { "dead_end_ants", "Ants stopped with no cell left to move to." },
+        { "step_budget_ants", "Ants still walking when the step budget ran out." },
+        { "best_path_improvements", "Iterations that shortened the best path." },
+        { "candidates", "Feasible cells weighed by the transition rule." }
+    };
+
+    // escapes backslashes, quotes and newlines; the same rules hold for JSON strings and Prometheus label values
+    std::string escape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '\\' || c == '"') escaped += '\\';
+            if (c == '\n') escaped += "\\n";
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+    void writeLabels(std::ostream& out, const LabeledMetrics& run, const char* firstName, const char* firstValue) {
+        bool first = true;
+        out << "{";
+        if (firstName) {
+            out << firstName << "=\"" << firstValue << "\"";
+            first = false;
+        }
+        for (const auto& label : run.labels) {
+            out << (first ? "" : ",") << label.first << "=\"" << escape(label.second) << "\"";
+            first = false;
+        }
+        out << "}";
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+void ColonyMetrics::reset(int maxIterations) {
+    for (double& seconds : phaseSeconds) {
+        seconds = 0.0;
+    }
+    for (long long& counter : counters) {
+        counter = 0;
+    }
+    arrivalsPerIteration.clear();
+    arrivalsPerIteration.reserve(maxIterations > 0 ? maxIterations : 0);
+}
+
+void MetricsExport::writeJson(std::ostream& out, const std::vector<LabeledMetrics>& runs) {
+    std::streamsize precision = out.precision(9);
+    out << "[";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const LabeledMetrics& run = runs[i];
+        out << (i ? "," : "") << "\n  {\n    \"labels\": {";
+        for (size_t j = 0; j < run.labels.size(); ++j) {
+            out << (j ? ", " : "") << "\"" << escape(run.labels[j].first) << "\": \"" << escape(run.labels[j].second) << "\"";
+        }
+        out << "},\n    \"phase_seconds\": {";
+        for (int phase = 0; phase < PhaseCount; ++phase) {
+            out << (phase ? ", " : "") << "\"" << phaseNames[phase] << "\": " << run.metrics.phaseSeconds[phase];
+        }
+        out << "},\n    \"counters\": {";
+        for (int counter = 0; counter < CounterCount; ++counter) {
+            out << (counter ? ", " : "") << "\"" << counterInfo[counter].name << "\": " << run.metrics.counters[counter];
+        }
+        out << "},\n    \"arrivals_per_iteration\": [";
+        for (size_t j = 0; j < run.metrics.arrivalsPerIteration.size(); ++j) {
+            out << (j ? ", " : "") << run.metrics.arrivalsPerIteration[j];
+        }
+        out << "]\n  }";
+    }
+    out << "\n]\n";
+    out.precision(precision);
+}
+
+// Samples of a metric stay together under its HELP and TYPE lines, as the format requires.
+void MetricsExport::writePrometheus(std::ostream& out, const std::vector<LabeledMetrics>& runs) {
+    std::streamsize precision = out.precision(9);
+    out << "# HELP antcolony_phase_seconds_total Time spent in each phase of the iteration loop.\n"
+        << "# TYPE antcolony_phase_seconds_total counter\n";
+    for (const LabeledMetrics& run : runs) {
+        for (int phase = 0; phase < PhaseCount; ++phase) {
+            out << "antcolony_phase_seconds_total";
+            writeLabels(out, run, "phase", phaseNames[phase]);
+            out << " " << run.metrics.phaseSeconds[phase] << "\n";
+        }
+    }
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        std::string name = std::string("antcolony_") + counterInfo[counter].name + "_total";
+        out << "# HELP " << name << " " << counterInfo[counter].help << "\n"
+            << "# TYPE " << name << " counter\n";
+        for (const LabeledMetrics& run : runs) {
+            out << name;
+            if (!run.labels.empty()) writeLabels(out, run, nullptr, nullptr);
+            out << " " << run.metrics.counters[counter] << "\n";
+        }
+    }
+    out.precision(precision);
+}
+
+void MetricsExport::save(const std::string& path, const std::vector<LabeledMetrics>& runs) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot write metrics file " + path);
+    }
+    if (endsWith(path, ".json")) writeJson(file, runs);
+    else writePrometheus(file, runs);
+    if (!file) {
+        throw std::runtime_error("cannot write metrics file " + path);
+    }
+}
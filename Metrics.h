@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Solver instrumentation. Built with ANTCOLONY_METRICS=0 (CMake option of the
+// same name) the macros below expand to unevaluated expressions, so the hot
+// paths carry no timers or counters at all and getMetrics() stays zero.
+#ifndef ANTCOLONY_METRICS
+#define ANTCOLONY_METRICS 1
+#endif
+
+enum MetricsPhase {
+    ConstructionPhase, // tour construction, all workers
+    CollectionPhase,   // gathering arrivals, loop erasure, best path
+    EvaporationPhase,
+    DepositPhase,
+    TelemetryPhase,    // recording iteration stats and pheromone snapshots
+    PhaseCount
+};
+
+enum MetricsCounter {
+    IterationsCounter,
+    AntStepsCounter,             // moves, including the ones undone by backtracking
+    ArrivedAntsCounter,
+    DeadEndAntsCounter,          // stopped with no cell left to move to
+    StepBudgetAntsCounter,       // still walking when the step budget ran out
+    BestPathImprovementsCounter,
+    CandidatesCounter,           // feasible cells weighed by the transition rule
+    CounterCount
+};
+
+struct ColonyMetrics {
+    double phaseSeconds[PhaseCount] = {};
+    long long counters[CounterCount] = {};
+    std::vector<int> arrivalsPerIteration;
+    void reset(int maxIterations); // reserves the per-iteration series
+};
+
+// Adds the lifetime of the timer to seconds.
+class MetricsTimer {
+public:
+    explicit MetricsTimer(double& seconds) : seconds(seconds), begin(std::chrono::steady_clock::now()) {}
+    ~MetricsTimer() { seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); }
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+
+private:
+    double& seconds;
+    std::chrono::steady_clock::time_point begin;
+};
+
+#define ANTCOLONY_METRICS_CONCAT2(a, b) a##b
+#define ANTCOLONY_METRICS_CONCAT(a, b) ANTCOLONY_METRICS_CONCAT2(a, b)
+#if ANTCOLONY_METRICS
+// times the rest of the enclosing scope
+#define ANTCOLONY_METRICS_TIMER(seconds) MetricsTimer ANTCOLONY_METRICS_CONCAT(metricsTimer, __LINE__)(seconds)
+#define ANTCOLONY_METRICS_ADD(counter, amount) ((counter) += (amount))
+#else
+#define ANTCOLONY_METRICS_TIMER(seconds) ((void)sizeof(seconds))
+#define ANTCOLONY_METRICS_ADD(counter, amount) ((void)sizeof((counter) += (amount)))
+#endif
+
+// One run's metrics and the labels that tell it apart from the others in a file.
+struct LabeledMetrics {
+    std::vector<std::pair<std::string, std::string>> labels; // e.g. {"kind", "maze"}
+    ColonyMetrics metrics;
+};
+
+namespace MetricsExport {
+    // an array with one object per run
+    void writeJson(std::ostream& out, const std::vector<LabeledMetrics>& runs);
+    // Prometheus text format, one sample per run and metric
+    void writePrometheus(std::ostream& out, const std::vector<LabeledMetrics>& runs);
+    // JSON for a .json path, the Prometheus text format otherwise; throws std::runtime_error
+    void save(const std::string& path, const std::vector<LabeledMetrics>& runs);
+}
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "PheromoneCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+    const char pheromoneMagic[8] = { 'A', 'C', 'O', 'P', 'H', 'E', 'R', 0 };
+
+    // rename() on Windows refuses to replace an existing file
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+}
+
+PheromoneCache::PheromoneCache(size_t capacity, const std::string& directory) : capacity(capacity), directory(directory) {}
+
+size_t PheromoneCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+bool PheromoneCache::load(const GridMap& map, int goalCell, PheromoneField& pheromones) {
+    Key key = { map.contentHash(), goalCell };
+    Field field;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            entries.splice(entries.begin(), entries, found->second);
+            field = found->second->second;
+        }
+    }
+    if (!field) {
+        field = readFile(key, map); // 内存里没有，再查磁盘
+        if (!field) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, field);
+    }
+    pheromones = *field;
+    return true;
+}
+
+void PheromoneCache::store(const GridMap& map, int goalCell, const PheromoneField& pheromones) {
+    if (pheromones.size() != map.getCellCount()) {
+        throw std::invalid_argument("pheromone field does not match the map size");
+    }
+    Key key = { map.contentHash(), goalCell };
+    Field field = std::make_shared<PheromoneField>(pheromones);
+    unsigned write;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, field);
+        write = writes++;
+    }
+    writeFile(key, map, *field, write);
+}
+
+// Callers hold the mutex.
+void PheromoneCache::insert(const Key& key, const Field& field) {
+    auto found = index.find(key);
+    if (found != index.end()) {
+        found->second->second = field;
+        entries.splice(entries.begin(), entries, found->second);
+        return;
+    }
+    if (capacity == 0) return;
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(key, field);
+    index[key] = entries.begin();
+}
+
+std::string PheromoneCache::filePath(const Key& key) const {
+    char name[48];
+    snprintf(name, sizeof(name), "%016llx_%d.pher", (unsigned long long)key.mapHash, key.goalCell);
+    return directory + "/" + name;
+}
+
+PheromoneCache::Field PheromoneCache::readFile(const Key& key, const GridMap& map) const {
+    if (directory.empty()) return Field();
+    std::ifstream in(filePath(key), std::ios::binary);
+    PheromoneFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return Field();
+    // 哈希相同时仍然核对尺寸，防止拿错文件
+    if (std::memcmp(header.magic, pheromoneMagic, sizeof(pheromoneMagic)) != 0 || header.mapHash != key.mapHash ||
+        header.goalCell != key.goalCell || (int)header.width != map.getWidth() || (int)header.height != map.getHeight()) {
+        return Field();
+    }
+    // Read one band of tile rows at a time. The first pass finds the value that most
+    // uniform tiles share: the untouched tiles of the stored field, which the second
+    // pass leaves unallocated.
+    int width = map.getWidth(), height = map.getHeight(), tileSize = PheromoneField::tileSize;
+    std::streampos payload = in.tellg();
+    std::vector<float> band((size_t)tileSize * width);
+    auto uniformTile = [&](int x0, int rows, float& value) {
+        value = band[x0];
+        for (int y = 0; y < rows; ++y) {
+            for (int x = x0; x < x0 + tileSize && x < width; ++x) {
+                if (band[(size_t)y * width + x] != value) return false;
+            }
+        }
+        return true;
+    };
+    std::map<float, int> uniformTiles;
+    for (int y0 = 0; y0 < height; y0 += tileSize) {
+        int rows = std::min(tileSize, height - y0);
+        if (!in.read(reinterpret_cast<char*>(band.data()), (std::streamsize)rows * width * sizeof(float))) return Field();
+        for (int x0 = 0; x0 < width; x0 += tileSize) {
+            float value;
+            if (uniformTile(x0, rows, value)) ++uniformTiles[value];
+        }
+    }
+    float base = 1.0f;
+    int most = 0;
+    for (const auto& entry : uniformTiles) {
+        if (entry.second > most) {
+            base = entry.first;
+            most = entry.second;
+        }
+    }
+    std::shared_ptr<PheromoneField> field = std::make_shared<PheromoneField>();
+    field->assign(width, height, base);
+    in.seekg(payload);
+    for (int y0 = 0; y0 < height; y0 += tileSize) {
+        int rows = std::min(tileSize, height - y0);
+        if (!in.read(reinterpret_cast<char*>(band.data()), (std::streamsize)rows * width * sizeof(float))) return Field();
+        for (int x0 = 0; x0 < width; x0 += tileSize) {
+            float value;
+            if (uniformTile(x0, rows, value) && value == base) continue;
+            for (int y = 0; y < rows; ++y) {
+                for (int x = x0; x < x0 + tileSize && x < width; ++x) {
+                    field->set(map.cellId(x, y0 + y), band[(size_t)y * width + x]);
+                }
+            }
+        }
+    }
+    return field;
+}
+
+// Written under a temporary name and renamed, so concurrent stores of the same
+// key and readers never see a partial file.
+void PheromoneCache::writeFile(const Key& key, const GridMap& map, const PheromoneField& field, unsigned write) const {
+    if (directory.empty()) return;
+    PheromoneFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, pheromoneMagic, sizeof(pheromoneMagic));
+    header.width = map.getWidth();
+    header.height = map.getHeight();
+    header.mapHash = key.mapHash;
+    header.goalCell = key.goalCell;
+    std::string path = filePath(key), temporary = path + "." + std::to_string(write) + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    // row by row, so no dense copy of the field is made
+    std::vector<float> row(map.getWidth());
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            row[x] = (float)field.value(map.cellId(x, y));
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+    }
+    out.close();
+    if (!out || !replaceFile(temporary, path)) std::remove(temporary.c_str());
+}
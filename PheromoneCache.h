@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef PHEROMONECACHE_H
+#define PHEROMONECACHE_H
+
+#include "GridMap.h"
+#include "PheromoneField.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Pheromone file: this header followed by width * height floats in cell-id order.
+struct PheromoneFileHeader {
+    char magic[8]; // "ACOPHER"
+    uint32_t width, height;
+    uint64_t mapHash; // GridMap::contentHash()
+    int32_t goalCell;
+    uint32_t reserved;
+};
+
+// Converged pheromone fields keyed by map contents and goal, so a colony for a
+// map and goal seen before can warm-start (AntColonyBase::setPheromones). The
+// most recently used fields are kept in memory, as tiled PheromoneFields, in
+// front of an optional directory of pheromone files. Safe to share between threads.
+class PheromoneCache {
+public:
+    // capacity: fields held in memory; directory: on-disk store, empty for none
+    explicit PheromoneCache(size_t capacity, const std::string& directory = "");
+    // Fills pheromones and returns true if a field for this map and goal is cached.
+    bool load(const GridMap& map, int goalCell, PheromoneField& pheromones);
+    // The file is written outside the lock. One that cannot be written is left
+    // out, so a later load from disk is a miss rather than an error.
+    void store(const GridMap& map, int goalCell, const PheromoneField& pheromones);
+    size_t size() const;
+
+private:
+    struct Key {
+        uint64_t mapHash;
+        int goalCell;
+        bool operator==(const Key& other) const { return mapHash == other.mapHash && goalCell == other.goalCell; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return (size_t)(key.mapHash ^ ((uint64_t)key.goalCell * 0x9E3779B97F4A7C15ULL)); }
+    };
+    typedef std::shared_ptr<const PheromoneField> Field;
+    typedef std::list<std::pair<Key, Field>> Entries;
+    size_t capacity;
+    std::string directory;
+    Entries entries; // most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+    unsigned writes = 0; // names the temporary files
+    mutable std::mutex mutex;
+    void insert(const Key& key, const Field& field);
+    std::string filePath(const Key& key) const;
+    Field readFile(const Key& key, const GridMap& map) const;
+    void writeFile(const Key& key, const GridMap& map, const PheromoneField& field, unsigned write) const;
+};
+
+#endif
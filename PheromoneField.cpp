@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "PheromoneField.h"
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+
+// (1 - 0.3)^130 is about 1e-20; stored values of new deposits stay below ~1e22
+const double PheromoneField::minScale = 1e-20;
+
+void PheromoneField::assign(int fieldWidth, int fieldHeight, double value) {
+    width = fieldWidth;
+    height = fieldHeight;
+    inverseWidth = 1.0 / width;
+    tilesPerRow = (width + tileSize - 1) >> tileShift;
+    tileSlots.assign((size_t)tilesPerRow * ((height + tileSize - 1) >> tileShift), -1);
+    pool.clear();
+    tileCount = 0;
+    initialValue = implicitValue = value;
+    scale = 1.0;
+    floor = scaledFloor = 0.0;
+}
+
+void PheromoneField::assign(const std::vector<double>& values) {
+    if ((int)values.size() != size()) {
+        throw std::invalid_argument("pheromone field does not match the map size");
+    }
+    assign(width, height, initialValue);
+    for (int cell = 0; cell < size(); ++cell) {
+        set(cell, values[cell]);
+    }
+}
+
+void PheromoneField::reserveTiles(int count) {
+    size_t needed = (size_t)(tileCount + count) * tileSize * tileSize;
+    if (needed > pool.capacity()) pool.reserve(std::max(needed, 2 * pool.capacity()));
+}
+
+void PheromoneField::reserveTiles(const int* cells, int count) {
+    int untouched = 0, previous = -1, offset;
+    for (int i = 0; i < count; ++i) {
+        int tile = locate(cells[i], offset);
+        if (tile != previous && tileSlots[tile] < 0) ++untouched;
+        previous = tile;
+    }
+    if (untouched) reserveTiles(untouched);
+}
+
+void PheromoneField::reserveRegion(int x0, int y0, int x1, int y1) {
+    int tileX0 = std::max(x0, 0) >> tileShift, tileX1 = std::min(x1, width - 1) >> tileShift;
+    int tileY0 = std::max(y0, 0) >> tileShift, tileY1 = std::min(y1, height - 1) >> tileShift;
+    int untouched = 0;
+    for (int tileY = tileY0; tileY <= tileY1; ++tileY) {
+        for (int tileX = tileX0; tileX <= tileX1; ++tileX) {
+            if (tileSlots[(size_t)tileY * tilesPerRow + tileX] < 0) ++untouched;
+        }
+    }
+    if (untouched) reserveTiles(untouched);
+}
+
+// Within the reserved capacity the resize does not allocate.
+float* PheromoneField::tileFor(int cell, int& offset) {
+    int& slot = tileSlots[locate(cell, offset)];
+    if (slot < 0) {
+        slot = tileCount++;
+        pool.resize((size_t)tileCount * tileSize * tileSize, (float)implicitValue);
+    }
+    return &pool[((size_t)slot << (2 * tileShift))];
+}
+
+void PheromoneField::evaporate(double rate) {
+    scale *= 1.0 - rate;
+    scaledFloor = floor / scale;
+    if (scale < minScale) normalize();
+}
+
+void PheromoneField::setFloor(double value) {
+    if (value < floor) normalize();
+    floor = value;
+    scaledFloor = floor / scale;
+}
+
+void PheromoneField::copyValues(std::vector<float>& values) const {
+    values.resize(size());
+    for (int cell = 0; cell < size(); ++cell) {
+        values[cell] = (float)value(cell);
+    }
+}
+
+void PheromoneField::blend(const PheromoneField& other, double weight) {
+    if (other.width != width || other.height != height) {
+        throw std::invalid_argument("pheromone field does not match the map size");
+    }
+    for (int tile = 0; tile < (int)tileSlots.size(); ++tile) {
+        if (tileSlots[tile] < 0 && other.tileSlots[tile] < 0) continue;
+        int x0 = (tile % tilesPerRow) << tileShift, y0 = (tile / tilesPerRow) << tileShift;
+        for (int y = y0; y < y0 + tileSize && y < height; ++y) {
+            for (int x = x0; x < x0 + tileSize && x < width; ++x) {
+                int cell = y * width + x;
+                set(cell, (1.0 - weight) * value(cell) + weight * other.value(cell));
+            }
+        }
+    }
+    // cells untouched in both fields
+    double own = std::max(implicitValue, scaledFloor) * scale;
+    double theirs = std::max(other.implicitValue, other.scaledFloor) * other.scale;
+    implicitValue = ((1.0 - weight) * own + weight * theirs) / scale;
+}
+
+// Values that would drop below the smallest normal float are kept there: a cell
+// nobody visited for long still has to weigh more than nothing in the roulette.
+void PheromoneField::normalize() {
+    auto fold = [this](double stored) {
+        double value = stored * scale;
+        if (value < floor) value = floor;
+        return value < FLT_MIN ? FLT_MIN : value;
+    };
+    for (float& stored : pool) {
+        stored = (float)fold(stored);
+    }
+    implicitValue = fold(implicitValue);
+    scale = 1.0;
+    scaledFloor = floor;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef PHEROMONEFIELD_H
+#define PHEROMONEFIELD_H
+
+#include <cstddef>
+#include <vector>
+
+// Pheromone per cell, stored sparsely and evaporated lazily.
+//
+// Cells are grouped into tiles of 64 x 64 floats, taken from a pool on the first
+// write; a cell of an untouched tile has the implicit value every cell started
+// with. Memory thus grows with the area the ants explore, not with the map, plus
+// a table of one int per tile. The pool only grows in reserveTiles (geometrically),
+// which depositAlongPath calls before depositing, so deposits never allocate.
+//
+// The value of a cell is max(stored * scale, floor), so evaporating all cells
+// only shrinks scale and deposits add amount / scale. Once scale falls below
+// minScale it is folded back into the allocated tiles and the implicit value
+// (one pass every ~130 iterations at rate 0.3), which keeps the stored values of
+// fresh deposits well inside float range, also under the alpha power.
+//
+// The stored values themselves are proportional to the field, which is all the
+// roulette wheel needs: it reads weight(cell) directly.
+class PheromoneField {
+public:
+    static const int tileShift = 6;
+    static const int tileSize = 1 << tileShift;
+
+    void assign(int width, int height, double value);
+    void assign(const std::vector<double>& values); // every cell, allocates all tiles
+    // (1 - weight) * this + weight * other, cell by cell; only tiles touched in
+    // either field are allocated. Both fields must have the same size.
+    void blend(const PheromoneField& other, double weight);
+    int size() const { return width * height; }
+    int allocatedTiles() const { return tileCount; }
+    // Makes room in the pool for count more tiles.
+    void reserveTiles(int count);
+    // Makes room for the untouched tiles of the given cells, e.g. of a path about
+    // to be deposited on. A tile the cells leave and re-enter is counted twice.
+    void reserveTiles(const int* cells, int count);
+    // Makes room for the untouched tiles overlapping cells x0..x1, y0..y1 (clipped).
+    void reserveRegion(int x0, int y0, int x1, int y1);
+    // stored value clamped to the floor, on the scale of the stored values
+    double weight(int cell) const {
+        int offset;
+        int slot = tileSlots[locate(cell, offset)];
+        double value = slot >= 0 ? pool[((size_t)slot << (2 * tileShift)) + offset] : implicitValue;
+        return value < scaledFloor ? scaledFloor : value;
+    }
+    double value(int cell) const { return weight(cell) * scale; }
+    void set(int cell, double value) {
+        int offset;
+        float* tile = tileFor(cell, offset);
+        tile[offset] = (float)((value < floor ? floor : value) / scale);
+    }
+    void deposit(int cell, double amount) {
+        int offset;
+        float* tile = tileFor(cell, offset);
+        double value = tile[offset] < scaledFloor ? scaledFloor : tile[offset];
+        tile[offset] = (float)(value + amount / scale);
+    }
+    void evaporate(double rate); // every cell times (1 - rate)
+    // Lower bound applied at read time (MaxMin's tauMin), 0 for none. Lowering it
+    // first folds the old bound into the cells, so values clamped by it stay.
+    void setFloor(double value);
+    // One float per cell of the map, for callers that need a dense array; costs
+    // O(cells) memory, so take it once and do not keep it. Copying the field
+    // itself only copies its allocated tiles.
+    void copyValues(std::vector<float>& values) const;
+
+private:
+    static const double minScale;
+    int width = 0, height = 0, tilesPerRow = 0;
+    std::vector<int> tileSlots; // per tile, its index in the pool; -1: every cell has implicitValue
+    std::vector<float> pool; // tileSize * tileSize floats per allocated tile
+    int tileCount = 0;
+    double initialValue = 1.0;
+    double implicitValue = 1.0; // stored value of the cells of unallocated tiles
+    double scale = 1.0;
+    double scaledFloor = 0.0; // floor / scale
+    double floor = 0.0;
+    double inverseWidth = 1.0;
+    // (cell + 0.5) / width is at least 0.5 / width away from an integer, far more
+    // than the rounding error of the multiplication, so y is exact without a division
+    int locate(int cell, int& offset) const {
+        int y = (int)((cell + 0.5) * inverseWidth), x = cell - y * width;
+        offset = ((y & (tileSize - 1)) << tileShift) | (x & (tileSize - 1));
+        return (y >> tileShift) * tilesPerRow + (x >> tileShift);
+    }
+    float* tileFor(int cell, int& offset);
+    void normalize();
+};
+
+#endif
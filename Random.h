@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstring>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// xoshiro256** generator seeded through SplitMix64. Each worker owns one, so
+// a run is reproducible for a given seed and thread count.
+class Random {
+public:
+    explicit Random(uint64_t seed = 1, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (auto& word : state) {
+            word = splitMix64(x);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // uniform in [0, 1)
+    double nextDouble() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static uint64_t splitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state[4];
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Four independent xoshiro256+ streams stored lane by lane, so one AVX2
+// register advances all of them at once. The scalar path yields the same numbers.
+class RandomLanes {
+public:
+    static const int lanes = 4;
+
+    explicit RandomLanes(uint64_t seed = 1, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (int word = 0; word < 4; ++word) {
+            for (int lane = 0; lane < lanes; ++lane) {
+                state[word][lane] = Random::splitMix64(x);
+            }
+        }
+    }
+
+    // four uniforms in [0, 1) with 52 random bits each
+    void nextDoubles(double* out) {
+#ifdef __AVX2__
+        _mm256_storeu_pd(out, nextVector());
+#else
+        for (int lane = 0; lane < lanes; ++lane) {
+            uint64_t result = state[0][lane] + state[3][lane];
+            uint64_t t = state[1][lane] << 17;
+            state[2][lane] ^= state[0][lane];
+            state[3][lane] ^= state[1][lane];
+            state[1][lane] ^= state[2][lane];
+            state[0][lane] ^= state[3][lane];
+            state[2][lane] ^= t;
+            state[3][lane] = (state[3][lane] << 45) | (state[3][lane] >> 19);
+            uint64_t bits = (result >> 12) | 0x3FF0000000000000ULL;
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            out[lane] = value - 1.0;
+        }
+#endif
+    }
+
+#ifdef __AVX2__
+    __m256d nextVector() {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)state[0]);
+        __m256i s1 = _mm256_loadu_si256((const __m256i*)state[1]);
+        __m256i s2 = _mm256_loadu_si256((const __m256i*)state[2]);
+        __m256i s3 = _mm256_loadu_si256((const __m256i*)state[3]);
+        __m256i result = _mm256_add_epi64(s0, s3);
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+        _mm256_storeu_si256((__m256i*)state[0], s0);
+        _mm256_storeu_si256((__m256i*)state[1], s1);
+        _mm256_storeu_si256((__m256i*)state[2], s2);
+        _mm256_storeu_si256((__m256i*)state[3], s3);
+        __m256i bits = _mm256_or_si256(_mm256_srli_epi64(result, 12), _mm256_set1_epi64x(0x3FF0000000000000LL));
+        return _mm256_sub_pd(_mm256_castsi256_pd(bits), _mm256_set1_pd(1.0));
+    }
+#endif
+
+private:
+    uint64_t state[4][lanes];
+};
+
+#endif
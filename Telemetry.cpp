@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Telemetry.h"
+#include <cstring>
+#include <utility>
+
+TelemetryWriter::TelemetryWriter(const TelemetrySettings& settings, int width, int height) : settings(settings) {
+    if (this->settings.downsample < 1) this->settings.downsample = 1;
+    if (this->settings.keyframeInterval < 1) this->settings.keyframeInterval = 1;
+    int downsample = this->settings.downsample;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, telemetryMagic, sizeof(header.magic));
+    header.version = 1;
+    header.width = width;
+    header.height = height;
+    header.snapshotWidth = (width + downsample - 1) / downsample;
+    header.snapshotHeight = (height + downsample - 1) / downsample;
+    header.downsample = downsample;
+    header.flags = this->settings.deltas ? TelemetryDeltas : 0;
+    header.keyframeInterval = this->settings.keyframeInterval;
+
+    file.open(settings.path, std::ios::binary | std::ios::trunc);
+    if (!file) return;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    open = true;
+    writer = std::thread(&TelemetryWriter::writerLoop, this);
+}
+
+TelemetryWriter::~TelemetryWriter() {
+    close();
+}
+
+bool TelemetryWriter::wantsSnapshot(int iteration) const {
+    return open && settings.snapshotInterval > 0 && iteration % settings.snapshotInterval == 0;
+}
+
+void TelemetryWriter::recordIteration(int iteration, const TelemetryIterationStats& stats) {
+    if (!open) return;
+    Job job;
+    job.type = IterationRecord;
+    job.iteration = iteration;
+    job.stats = stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void TelemetryWriter::recordPheromones(int iteration, const PheromoneField& pheromones) {
+    if (!open) return;
+    Job job;
+    job.type = SnapshotRecord;
+    job.iteration = iteration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queuedSnapshots >= settings.maxQueuedSnapshots) {
+            ++droppedSnapshots;
+            return;
+        }
+        ++queuedSnapshots;
+        if (!spareFields.empty()) {
+            std::swap(job.pheromones, spareFields.back());
+            spareFields.pop_back();
+        }
+    }
+    job.pheromones = pheromones; // reuses the tiles of the recycled field
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void TelemetryWriter::close() {
+    if (!open) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    header.indexOffset = (uint64_t)file.tellp();
+    header.indexCount = index.size();
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(TelemetryIndexEntry));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    open = false;
+}
+
+void TelemetryWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return closing || !queue.empty(); });
+        if (queue.empty()) return; // closing and drained
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        if (job.type == IterationRecord) {
+            writeRecord(IterationRecord, job.iteration, 0, &job.stats, sizeof(job.stats));
+        }
+        else {
+            writeSnapshot(job);
+        }
+        lock.lock();
+        if (job.type == SnapshotRecord) {
+            --queuedSnapshots;
+            spareFields.push_back(std::move(job.pheromones));
+        }
+    }
+}
+
+void TelemetryWriter::writeRecord(uint32_t type, int iteration, uint32_t keyframe, const void* payload, uint64_t bytes) {
+    TelemetryIndexEntry entry = { type, iteration, (uint64_t)file.tellp() };
+    index.push_back(entry);
+    TelemetryRecordHeader record = { type, iteration, keyframe, 0, bytes };
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    file.write(reinterpret_cast<const char*>(payload), bytes);
+    static const char padding[8] = {};
+    if (bytes % 8) file.write(padding, 8 - bytes % 8);
+}
+
+void TelemetryWriter::writeSnapshot(const Job& job) {
+    int width = header.width, height = header.height, downsample = header.downsample;
+    int snapshotWidth = header.snapshotWidth;
+    snapshot.assign((size_t)snapshotWidth * header.snapshotHeight, 0.0f);
+    // 按块求平均
+    for (int sy = 0; sy < (int)header.snapshotHeight; ++sy) {
+        for (int sx = 0; sx < snapshotWidth; ++sx) {
+            double sum = 0.0;
+            int count = 0;
+            for (int y = sy * downsample; y < height && y < (sy + 1) * downsample; ++y) {
+                for (int x = sx * downsample; x < width && x < (sx + 1) * downsample; ++x) {
+                    sum += job.pheromones.value(y * width + x);
+                    ++count;
+                }
+            }
+            snapshot[(size_t)sy * snapshotWidth + sx] = (float)(sum / count);
+        }
+    }
+
+    bool keyframe = !settings.deltas || snapshotsWritten % settings.keyframeInterval == 0;
+    const std::vector<float>* payload = &snapshot;
+    if (!keyframe) {
+        encoded.resize(snapshot.size());
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            encoded[i] = snapshot[i] - previousSnapshot[i];
+        }
+        payload = &encoded;
+    }
+    writeRecord(SnapshotRecord, job.iteration, keyframe ? 1 : 0, payload->data(), payload->size() * sizeof(float));
+    // deltas are taken against the previous snapshot as the reader will reconstruct it
+    if (settings.deltas) {
+        if (keyframe) {
+            previousSnapshot = snapshot;
+        }
+        else {
+            for (size_t i = 0; i < snapshot.size(); ++i) {
+                previousSnapshot[i] += encoded[i];
+            }
+        }
+    }
+    ++snapshotsWritten;
+}
+
+TelemetryReader::TelemetryReader(const std::string& path) : file(path, std::ios::binary) {
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return;
+    if (std::memcmp(header.magic, telemetryMagic, sizeof(header.magic)) != 0 || header.version != 1) return;
+    if (header.indexOffset != 0) {
+        index.resize(header.indexCount);
+        file.seekg(header.indexOffset);
+        file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(TelemetryIndexEntry));
+    }
+    else {
+        // 没有索引（写入未正常结束），顺序扫描记录
+        TelemetryRecordHeader record;
+        uint64_t offset = sizeof(header);
+        while (file.seekg(offset) && file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            TelemetryIndexEntry entry = { record.type, record.iteration, offset };
+            uint64_t next = offset + sizeof(record) + (record.payloadBytes + 7) / 8 * 8;
+            file.seekg(0, std::ios::end);
+            if ((uint64_t)file.tellg() < next) break;
+            index.push_back(entry);
+            offset = next;
+        }
+        file.clear();
+    }
+    valid = (bool)file;
+}
+
+bool TelemetryReader::readRecord(const TelemetryIndexEntry& entry, TelemetryRecordHeader& record, void* payload, uint64_t capacity) {
+    file.seekg(entry.offset);
+    if (!file.read(reinterpret_cast<char*>(&record), sizeof(record)) || record.payloadBytes > capacity) return false;
+    return (bool)file.read(reinterpret_cast<char*>(payload), record.payloadBytes);
+}
+
+bool TelemetryReader::readIterationStats(const TelemetryIndexEntry& entry, TelemetryIterationStats& stats) {
+    TelemetryRecordHeader record;
+    return entry.type == IterationRecord && readRecord(entry, record, &stats, sizeof(stats));
+}
+
+bool TelemetryReader::readSnapshot(size_t entryIndex, std::vector<float>& values) {
+    if (entryIndex >= index.size()) return false;
+    size_t cells = (size_t)header.snapshotWidth * header.snapshotHeight;
+    // 找到最近的关键帧，再依次叠加差分
+    std::vector<size_t> chain;
+    TelemetryRecordHeader record;
+    for (size_t i = entryIndex + 1; i-- > 0;) {
+        if (index[i].type != SnapshotRecord) continue;
+        file.seekg(index[i].offset);
+        if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) return false;
+        chain.push_back(i);
+        if (record.keyframe) break;
+    }
+    if (chain.empty() || !record.keyframe) return false;
+    values.assign(cells, 0.0f);
+    std::vector<float> delta(cells);
+    for (size_t i = chain.size(); i-- > 0;) {
+        if (!readRecord(index[chain[i]], record, delta.data(), cells * sizeof(float))) return false;
+        for (size_t cell = 0; cell < cells; ++cell) {
+            values[cell] = record.keyframe ? delta[cell] : values[cell] + delta[cell];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "PheromoneField.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Telemetry file layout (native byte order, every block 8-byte aligned so the
+// file can be memory-mapped and read in place):
+//   TelemetryHeader
+//   records: TelemetryRecordHeader followed by payloadBytes of payload
+//     IterationRecord: TelemetryIterationStats
+//     SnapshotRecord:  float[snapshotWidth * snapshotHeight], row-major; with
+//                      TelemetryDeltas set, non-keyframes hold the difference
+//                      to the previous snapshot
+//   TelemetryIndexEntry[indexCount] at indexOffset, written on close
+// A file without an index (indexOffset == 0) can still be scanned record by record.
+
+const char telemetryMagic[8] = { 'A', 'C', 'O', 'T', 'E', 'L', 'E', '1' };
+const uint32_t TelemetryDeltas = 1;
+
+enum TelemetryRecordType : uint32_t {
+    IterationRecord = 1,
+    SnapshotRecord = 2
+};
+
+struct TelemetryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width, height; // map size in cells
+    uint32_t snapshotWidth, snapshotHeight;
+    uint32_t downsample; // a snapshot value is the mean of a downsample x downsample block
+    uint32_t flags;
+    uint32_t keyframeInterval;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint32_t reserved[2];
+};
+
+struct TelemetryRecordHeader {
+    uint32_t type;
+    int32_t iteration;
+    uint32_t keyframe; // snapshots: 1 if the values are absolute
+    uint32_t reserved;
+    uint64_t payloadBytes;
+};
+
+struct TelemetryIterationStats {
+    double bestPathLength; // -1 while no path has been found
+    double averagePathLength; // of the ants that arrived, -1 if none did
+    double elapsedSeconds;
+    int32_t arrivedAnts;
+    int32_t reserved;
+};
+
+struct TelemetryIndexEntry {
+    uint32_t type;
+    int32_t iteration;
+    uint64_t offset; // of the record header
+};
+
+struct TelemetrySettings {
+    std::string path; // empty disables telemetry
+    int snapshotInterval = 1; // pheromone snapshot every n iterations, 0 for none
+    int downsample = 1;
+    bool deltas = false;
+    int keyframeInterval = 16; // with deltas, every n-th snapshot is stored whole
+    int maxQueuedSnapshots = 4; // further snapshots are dropped while the writer is behind
+};
+
+// Appends telemetry records on a background thread. The solver thread only
+// copies the allocated tiles of the pheromone field into a recycled one.
+class TelemetryWriter {
+public:
+    TelemetryWriter(const TelemetrySettings& settings, int width, int height);
+    ~TelemetryWriter();
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+    bool isOpen() const { return open; }
+    bool wantsSnapshot(int iteration) const;
+    void recordIteration(int iteration, const TelemetryIterationStats& stats);
+    void recordPheromones(int iteration, const PheromoneField& pheromones);
+    int getDroppedSnapshots() const { return droppedSnapshots; }
+    void close(); // drains the queue and writes the index
+
+private:
+    struct Job {
+        uint32_t type;
+        int iteration;
+        TelemetryIterationStats stats;
+        PheromoneField pheromones;
+    };
+    TelemetrySettings settings;
+    TelemetryHeader header;
+    std::ofstream file;
+    bool open = false;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> queue;
+    std::vector<PheromoneField> spareFields;
+    int queuedSnapshots = 0;
+    int droppedSnapshots = 0;
+    bool closing = false;
+    // writer thread only
+    std::vector<TelemetryIndexEntry> index;
+    std::vector<float> snapshot, previousSnapshot, encoded;
+    int snapshotsWritten = 0;
+    void writerLoop();
+    void writeRecord(uint32_t type, int iteration, uint32_t keyframe, const void* payload, uint64_t bytes);
+    void writeSnapshot(const Job& job);
+};
+
+// Reads a telemetry file written by TelemetryWriter.
+class TelemetryReader {
+public:
+    explicit TelemetryReader(const std::string& path);
+    bool isValid() const { return valid; }
+    const TelemetryHeader& getHeader() const { return header; }
+    const std::vector<TelemetryIndexEntry>& getIndex() const { return index; }
+    bool readIterationStats(const TelemetryIndexEntry& entry, TelemetryIterationStats& stats);
+    // absolute snapshot values; delta records are resolved from the preceding keyframe.
+    // False when entryIndex is past the index or no keyframe precedes it.
+    bool readSnapshot(size_t entryIndex, std::vector<float>& values);
+
+private:
+    std::ifstream file;
+    TelemetryHeader header;
+    std::vector<TelemetryIndexEntry> index;
+    bool valid = false;
+    bool readRecord(const TelemetryIndexEntry& entry, TelemetryRecordHeader& record, void* payload, uint64_t capacity);
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount) {
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+    if (count <= 0) return;
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) task(i);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    currentTask = &task;
+    taskCount = count;
+    nextTask = 0;
+    unfinished = count;
+    ++generation;
+    wake.notify_all();
+    runTasks(lock);
+    finished.wait(lock, [this] { return unfinished == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock) {
+    while (nextTask < taskCount) {
+        int index = nextTask++;
+        const std::function<void(int)>& task = *currentTask;
+        lock.unlock();
+        task(index);
+        lock.lock();
+        if (--unfinished == 0) {
+            finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) return;
+        seenGeneration = generation;
+        runTasks(lock);
+    }
+}
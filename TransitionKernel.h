@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef TRANSITIONKERNEL_H
+#define TRANSITIONKERNEL_H
+
+#include "Random.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Roulette-wheel selection for a block of RandomLanes::lanes ants. Lane l has
+// counts[l] feasible cells in candidates[l]; unused slots must hold a valid
+// cell id (0 is fine) and are ignored. The weight of a cell is
+// alpha.apply(pheromones.weight(cell)) * heuristic[cell], and choices[l] receives
+// the selected slot. The weights only need to be proportional to the field (see
+// PheromoneField).
+// With AVX2 every lane is handled by one vector operation per slot; without it
+// the same arithmetic runs lane by lane.
+template <class Alpha, int MaxDegree, class Pheromones>
+void selectNextNodes(const int (*candidates)[MaxDegree], const int* counts, const Pheromones& pheromones,
+                     const double* heuristic, const Alpha& alpha, RandomLanes& random, int* choices) {
+    const int lanes = RandomLanes::lanes;
+    int slots = 0;
+    for (int lane = 0; lane < lanes; ++lane) {
+        if (counts[lane] > slots) slots = counts[lane];
+    }
+#ifdef __AVX2__
+    __m256d cumulative[MaxDegree];
+    __m256d sum = _mm256_setzero_pd();
+    __m256i countVector = _mm256_setr_epi64x(counts[0], counts[1], counts[2], counts[3]);
+    for (int k = 0; k < slots; ++k) {
+        __m128i ids = _mm_setr_epi32(candidates[0][k], candidates[1][k], candidates[2][k], candidates[3][k]);
+        __m256d valid = _mm256_castsi256_pd(_mm256_cmpgt_epi64(countVector, _mm256_set1_epi64x(k)));
+        // the tiled field has no gather; unused slots hold valid ids and get eta = 0
+        __m256d pheromone = _mm256_setr_pd(pheromones.weight(candidates[0][k]), pheromones.weight(candidates[1][k]),
+                                           pheromones.weight(candidates[2][k]), pheromones.weight(candidates[3][k]));
+        __m256d eta = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), heuristic, ids, valid, 8);
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(alpha.apply(pheromone), eta)); // masked lanes add 0
+        cumulative[k] = sum;
+    }
+    // the chosen slot is the number of cumulative sums below the random target
+    __m256d target = _mm256_mul_pd(random.nextVector(), sum);
+    __m256i index = _mm256_setzero_si256();
+    for (int k = 0; k < slots; ++k) {
+        index = _mm256_sub_epi64(index, _mm256_castpd_si256(_mm256_cmp_pd(target, cumulative[k], _CMP_GT_OQ)));
+    }
+    alignas(32) long long selected[lanes];
+    _mm256_store_si256((__m256i*)selected, index);
+#else
+    double cumulative[MaxDegree][lanes];
+    double sum[lanes] = { 0.0, 0.0, 0.0, 0.0 };
+    for (int k = 0; k < slots; ++k) {
+        for (int lane = 0; lane < lanes; ++lane) {
+            int id = candidates[lane][k];
+            double weight = alpha.apply(pheromones.weight(id)) * heuristic[id];
+            if (k < counts[lane]) sum[lane] += weight;
+            cumulative[k][lane] = sum[lane];
+        }
+    }
+    double target[lanes];
+    random.nextDoubles(target);
+    long long selected[lanes];
+    for (int lane = 0; lane < lanes; ++lane) {
+        target[lane] *= sum[lane];
+        selected[lane] = 0;
+        for (int k = 0; k < slots; ++k) {
+            if (target[lane] > cumulative[k][lane]) ++selected[lane];
+        }
+    }
+#endif
+    for (int lane = 0; lane < lanes; ++lane) {
+        choices[lane] = selected[lane] < counts[lane] ? (int)selected[lane] : 0; // 默认返回第一个节点作为后备
+    }
+}
+
+#endif
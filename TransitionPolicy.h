@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef TRANSITIONPOLICY_H
+#define TRANSITIONPOLICY_H
+
+#include "GridMap.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Policy types for BasicAntColony. They are resolved at compile time, so the
+// transition rule in the step loop has no runtime switches or pow() calls.
+
+// Neighborhoods: which neighbor table the ants walk and what a step costs.
+struct FourConnected {
+    static const int connectivity = 4;
+    static const int maxDegree = 4;
+    static double stepCost(int, int, int) { return 1.0; }
+};
+
+struct EightConnected {
+    static const int connectivity = 8;
+    static const int maxDegree = 8;
+    static double stepCost(int from, int to, int width) {
+        int delta = abs(to - from);
+        return (delta == 1 || delta == width) ? 1.0 : 1.4142135623730951;
+    }
+};
+
+// Heuristics: distance estimate from a cell to the goal. It is evaluated once
+// per cell when the colony builds its heuristic table.
+struct EuclideanHeuristic {
+    static const char* name() { return "euclidean"; }
+    static double distance(const GridMap& map, int cell, int goal, const std::vector<double>&) {
+        double dx = map.cellX(cell) - map.cellX(goal), dy = map.cellY(cell) - map.cellY(goal);
+        return sqrt(dx * dx + dy * dy);
+    }
+};
+
+struct ManhattanHeuristic {
+    static const char* name() { return "manhattan"; }
+    static double distance(const GridMap& map, int cell, int goal, const std::vector<double>&) {
+        return abs(map.cellX(cell) - map.cellX(goal)) + abs(map.cellY(cell) - map.cellY(goal));
+    }
+};
+
+// Distances supplied per cell through setHeuristicDistances; uniform until then.
+struct LookupTableHeuristic {
+    static const char* name() { return "lookup"; }
+    static double distance(const GridMap&, int cell, int, const std::vector<double>& distances) {
+        return distances.empty() ? 1.0 : distances[cell];
+    }
+};
+
+// Exponents: IntExponent<3>::apply(x) compiles to x * x * x.
+template <int N>
+struct IntExponent {
+    static double value() { return N; }
+    static double apply(double value) { return value * IntExponent<N - 1>::apply(value); }
+#ifdef __AVX2__
+    static __m256d apply(__m256d value) { return _mm256_mul_pd(value, IntExponent<N - 1>::apply(value)); }
+#endif
+};
+
+template <>
+struct IntExponent<1> {
+    static double value() { return 1; }
+    static double apply(double value) { return value; }
+#ifdef __AVX2__
+    static __m256d apply(__m256d value) { return value; }
+#endif
+};
+
+template <>
+struct IntExponent<0> {
+    static double value() { return 0; }
+    static double apply(double) { return 1.0; }
+#ifdef __AVX2__
+    static __m256d apply(__m256d) { return _mm256_set1_pd(1.0); }
+#endif
+};
+
+// Exponent chosen at run time (see BasicAntColony::setExponents). Anything but
+// 1 costs a pow() per call, so colonies with fixed exponents should keep using IntExponent.
+struct RuntimeExponent {
+    double exponent = 1.0;
+    double value() const { return exponent; }
+    double apply(double value) const { return exponent == 1.0 ? value : pow(value, exponent); }
+#ifdef __AVX2__
+    __m256d apply(__m256d value) const {
+        if (exponent == 1.0) return value;
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, value);
+        for (double& lane : lanes) {
+            lane = pow(lane, exponent);
+        }
+        return _mm256_load_pd(lanes);
+    }
+#endif
+};
+
+#endif
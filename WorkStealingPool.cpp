@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "WorkStealingPool.h"
+
+namespace {
+    thread_local const WorkStealingPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threadCount) : pending(0), nextQueue(0) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; ++i) {
+        queues.emplace_back(new Queue());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::push(std::function<void()> task) {
+    // tasks submitted from a worker stay on its own queue
+    int index = currentPool == this ? currentWorker : (int)(nextQueue++ % queues.size());
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+bool WorkStealingPool::take(int worker, std::function<void()>& task) {
+    int count = (int)queues.size();
+    for (int i = 0; i < count; ++i) {
+        Queue& queue = *queues[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front()); // 从别的队列偷最早的任务
+            queue.tasks.pop_front();
+        }
+        --pending;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    currentPool = this;
+    currentWorker = worker;
+    std::function<void()> task;
+    while (true) {
+        if (take(worker, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this] { return stopping || pending > 0; });
+        if (stopping && pending == 0) return;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Independent tasks on a fixed set of workers, each with its own queue. A worker
+// takes its newest task first and, when its queue is empty, steals the oldest
+// task of another worker. Unlike ThreadPool the caller does not take part;
+// results come back through futures. Queued tasks still run on destruction.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threadCount);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    int getThreadCount() const { return (int)workers.size(); }
+    // Exceptions thrown by task are rethrown from the future's get(). A task must
+    // not wait for a task submitted after it.
+    template <class Task>
+    std::future<typename std::result_of<Task()>::type> submit(Task task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues; // one per worker
+    std::vector<std::thread> workers;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<int> pending; // queued and not yet taken
+    std::atomic<unsigned> nextQueue;
+    bool stopping = false;
+    void push(std::function<void()> task);
+    bool take(int worker, std::function<void()>& task);
+    void workerLoop(int worker);
+};
+
+template <class Task>
+std::future<typename std::result_of<Task()>::type> WorkStealingPool::submit(Task task) {
+    typedef typename std::result_of<Task()>::type Result;
+    // packaged_task is move-only, std::function needs a copyable target
+    std::shared_ptr<std::packaged_task<Result()>> packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> future = packaged->get_future();
+    push([packaged] { (*packaged)(); });
+    return future;
+}
+
+#endif
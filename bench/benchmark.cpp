@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// Solver benchmark on synthetic maps. For every map kind and size it reports
+// ant-steps per second, iteration latency, the time until the best path is
+// within a given percentage of the BFS optimum, moves per arrived ant, heap allocations per iteration
+// once the colony is warmed up (expected to be 0), and the process peak RSS.
+// With --metrics the solver's phase timers and counters of every run are saved as well.
+#include "../AntColony.h"
+#include "../MapGenerator.h"
+#include "../Metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Every heap allocation of the process goes through these.
+static std::atomic<long long> heapAllocations(0);
+
+void* operator new(std::size_t size) {
+    ++heapAllocations;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    const int warmupIterations = 2; // allocations of the first iterations are not counted
+
+    struct Options {
+        std::vector<int> sizes = { 25, 64, 256, 1024 };
+        std::vector<std::string> kinds = { "random", "maze", "corridors", "rooms" };
+        int ants = 256;
+        int iterations = 30;
+        int threads = 1;
+        uint64_t seed = 1;
+        double within = 10.0; // percent above the optimum
+        ConstructionSettings construction;
+        bool prune = false; // run on GridMap::pruneDeadEnds of each map
+        std::string csv;
+        std::string metrics; // .json for JSON, Prometheus text format otherwise
+    };
+
+    std::vector<std::string> split(const std::string& text) {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, ',')) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) return false;
+            std::string value = argv[++i];
+            if (arg == "--sizes") {
+                options.sizes.clear();
+                for (const auto& size : split(value)) options.sizes.push_back(std::atoi(size.c_str()));
+            }
+            else if (arg == "--kinds") options.kinds = split(value);
+            else if (arg == "--ants") options.ants = std::atoi(value.c_str());
+            else if (arg == "--iterations") options.iterations = std::atoi(value.c_str());
+            else if (arg == "--threads") options.threads = std::atoi(value.c_str());
+            else if (arg == "--seed") options.seed = std::strtoull(value.c_str(), nullptr, 10);
+            else if (arg == "--within") options.within = std::atof(value.c_str());
+            else if (arg == "--csv") options.csv = value;
+            else if (arg == "--metrics") options.metrics = value;
+            else if (arg == "--avoid-visited") options.construction.avoidVisited = std::atoi(value.c_str()) != 0;
+            else if (arg == "--erase-loops") options.construction.eraseLoops = std::atoi(value.c_str()) != 0;
+            else if (arg == "--bidirectional") options.construction.bidirectional = std::atoi(value.c_str()) != 0;
+            else if (arg == "--compress-corridors") options.construction.compressCorridors = std::atoi(value.c_str()) != 0;
+            else if (arg == "--prune") options.prune = std::atoi(value.c_str()) != 0;
+            else return false;
+        }
+        return true;
+    }
+
+    // shortest 4-connected path length in steps, -1 if the goal is unreachable
+    int bfsOptimum(const GridMap& map, std::pair<int, int> start, std::pair<int, int> goal) {
+        const NeighborTable& neighbors = map.getNeighborTable(4);
+        std::vector<int> distance(map.getCellCount(), -1);
+        std::vector<int> queue;
+        int startCell = map.cellId(start.first, start.second), goalCell = map.cellId(goal.first, goal.second);
+        distance[startCell] = 0;
+        queue.push_back(startCell);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int cell = queue[head];
+            if (cell == goalCell) break;
+            for (const int* next = neighbors.begin(cell); next != neighbors.end(cell); ++next) {
+                if (distance[*next] < 0) {
+                    distance[*next] = distance[cell] + 1;
+                    queue.push_back(*next);
+                }
+            }
+        }
+        return distance[goalCell];
+    }
+
+    double peakRssMegabytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: antcolony_bench [--sizes 25,64,256,1024,4096] [--kinds random,maze,corridors,rooms]\n"
+                     "                       [--ants n] [--iterations n] [--threads n] [--seed n] [--within percent] [--csv file]\n"
+                     "                       [--avoid-visited 0|1] [--erase-loops 0|1] [--bidirectional 0|1]\n"
+                     "                       [--compress-corridors 0|1] [--prune 0|1] [--metrics file.json|file.prom]"
+                  << std::endl;
+        return 1;
+    }
+    std::ofstream csv;
+    if (!options.csv.empty()) {
+        csv.open(options.csv);
+        csv << "kind,size,optimum,best,ant_steps_per_sec,mean_iteration_ms,max_iteration_ms,time_to_within_s,steps_per_arrival,allocs_per_iteration,peak_rss_mb\n";
+    }
+    std::cout << std::left << std::setw(10) << "kind" << std::right << std::setw(6) << "size" << std::setw(9) << "optimum"
+              << std::setw(9) << "best" << std::setw(14) << "steps/s" << std::setw(12) << "iter ms" << std::setw(12)
+              << "max ms" << std::setw(12) << "within s" << std::setw(12) << "steps/arr" << std::setw(10) << "allocs" << std::setw(10) << "rss MB" << std::endl;
+    std::vector<LabeledMetrics> metrics;
+
+    for (const auto& kind : options.kinds) {
+        for (int size : options.sizes) {
+            GeneratedMap generated = MapGenerator::generate(kind, size, size, options.seed);
+            int optimum = bfsOptimum(generated.map, generated.start, generated.goal);
+            if (options.prune) generated.map = generated.map.pruneDeadEnds(generated.start, generated.goal);
+
+            AntColony colony(generated.map, options.ants, options.iterations, generated.start, generated.goal);
+            colony.setThreadCount(options.threads);
+            colony.setSeed(options.seed);
+            colony.setConstructionSettings(options.construction);
+            double previousElapsed = 0.0, maxIteration = 0.0, timeToWithin = -1.0;
+            double target = optimum * (1.0 + options.within / 100.0);
+            long long warmAllocations = 0, lastAllocations = 0;
+            int lastIteration = 0;
+            long long arrivals = 0;
+            colony.setProgressCallback([&](const ProgressInfo& info) {
+                if (info.finished) return;
+                if (info.iteration == warmupIterations) warmAllocations = heapAllocations;
+                lastAllocations = heapAllocations;
+                lastIteration = info.iteration;
+                arrivals += info.arrivedAnts;
+                maxIteration = std::max(maxIteration, info.elapsedSeconds - previousElapsed);
+                previousElapsed = info.elapsedSeconds;
+                if (timeToWithin < 0.0 && optimum >= 0 && info.bestPathLength >= 0.0 && info.bestPathLength <= target) {
+                    timeToWithin = info.elapsedSeconds;
+                }
+            }, 0.0);
+
+            auto begin = std::chrono::steady_clock::now();
+            colony.run();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+            double stepsPerSecond = colony.getAntSteps() / elapsed.count();
+            double meanIteration = 1000.0 * elapsed.count() / std::max(1, colony.getIterationsRun());
+            double rss = peakRssMegabytes();
+            double allocations = lastIteration > warmupIterations
+                ? (double)(lastAllocations - warmAllocations) / (lastIteration - warmupIterations) : -1.0;
+            double stepsPerArrival = arrivals ? (double)colony.getAntSteps() / arrivals : -1.0;
+            std::cout << std::left << std::setw(10) << kind << std::right << std::setw(6) << size << std::setw(9) << optimum
+                      << std::setw(9) << colony.getBestPathLength() << std::setw(14) << std::setprecision(4)
+                      << stepsPerSecond << std::setw(12) << meanIteration << std::setw(12) << 1000.0 * maxIteration
+                      << std::setw(12) << timeToWithin << std::setw(12) << stepsPerArrival << std::setw(10) << allocations << std::setw(10) << rss << std::endl;
+            if (csv) {
+                csv << kind << "," << size << "," << optimum << "," << colony.getBestPathLength() << "," << stepsPerSecond
+                    << "," << meanIteration << "," << 1000.0 * maxIteration << "," << timeToWithin << "," << stepsPerArrival << "," << allocations
+                    << "," << rss << "\n";
+            }
+            if (!options.metrics.empty()) {
+                LabeledMetrics run;
+                run.labels = { { "kind", kind }, { "size", std::to_string(size) }, { "threads", std::to_string(options.threads) } };
+                run.metrics = colony.getMetrics();
+                metrics.push_back(run);
+            }
+        }
+    }
+    if (!options.metrics.empty()) {
+        MetricsExport::save(options.metrics, metrics);
+    }
+    return 0;
+}
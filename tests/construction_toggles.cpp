@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// Construction settings switched on in the middle of a run, from a progress
+// callback and between resume() calls, must take effect on the next iteration.
+// Exits with 1 and names the setting if a run fails or returns a broken path.
+#include "../AntColony.h"
+#include "../MapGenerator.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // what prepareConstruction sets up for the settings, seen from outside
+    struct Probe : AntColony {
+        using AntColony::AntColony;
+        bool visitedMarksReady() const { return !visitedMarks.empty(); }
+        bool trailMarksReady() const { return !trailMarks.stamps.empty(); }
+        bool corridorsReady() const { return corridors != nullptr; }
+    };
+
+    struct Toggle {
+        const char* name;
+        std::function<void(ConstructionSettings&)> enable;
+        std::function<bool(const Probe&)> inEffect;
+    };
+
+    bool validPath(const GeneratedMap& generated, const AntColonyBase& colony) {
+        const std::vector<int>& path = colony.getBestPath();
+        const GridMap& map = generated.map;
+        if (path.empty()) return true; // no ant arrived, nothing to check
+        if (path.front() != map.cellId(generated.start.first, generated.start.second) ||
+            path.back() != map.cellId(generated.goal.first, generated.goal.second)) {
+            return false;
+        }
+        const NeighborTable& neighbors = map.getNeighborTable(4);
+        for (size_t i = 0; i + 1 < path.size(); ++i) {
+            if (std::find(neighbors.begin(path[i]), neighbors.end(path[i]), path[i + 1]) == neighbors.end(path[i])) return false;
+        }
+        return true;
+    }
+}
+
+int main() {
+    const std::vector<Toggle> toggles = {
+        { "avoidVisited", [](ConstructionSettings& settings) { settings.avoidVisited = true; },
+          [](const Probe& colony) { return colony.visitedMarksReady(); } },
+        { "eraseLoops", [](ConstructionSettings& settings) { settings.eraseLoops = true; },
+          [](const Probe&) { return true; } },
+        { "bidirectional", [](ConstructionSettings& settings) { settings.bidirectional = true; },
+          [](const Probe& colony) { return colony.trailMarksReady(); } },
+        { "compressCorridors", [](ConstructionSettings& settings) { settings.compressCorridors = true; },
+          [](const Probe& colony) { return colony.corridorsReady(); } },
+        { "bidirectional with eraseLoops", [](ConstructionSettings& settings) { settings.bidirectional = settings.eraseLoops = true; },
+          [](const Probe& colony) { return colony.trailMarksReady(); } },
+    };
+    GeneratedMap generated = MapGenerator::generate("rooms", 64, 64, 3);
+    int failures = 0;
+    for (const Toggle& toggle : toggles) {
+        for (int threads : { 1, 2 }) {
+            // from the progress callback after the second iteration
+            Probe fromCallback(generated.map, 64, 6, generated.start, generated.goal);
+            fromCallback.setThreadCount(threads);
+            fromCallback.setProgressCallback([&](const ProgressInfo& info) {
+                if (info.iteration != 2) return;
+                ConstructionSettings settings;
+                toggle.enable(settings);
+                fromCallback.setConstructionSettings(settings);
+            }, 0.0);
+            fromCallback.run();
+            // between resume() calls
+            Probe resumed(generated.map, 64, 6, generated.start, generated.goal);
+            resumed.setThreadCount(threads);
+            resumed.resume(3);
+            ConstructionSettings settings;
+            toggle.enable(settings);
+            resumed.setConstructionSettings(settings);
+            resumed.resume(3);
+            for (const Probe* colony : { &fromCallback, &resumed }) {
+                if (colony->getIterationsRun() != 6 || !validPath(generated, *colony) || !toggle.inEffect(*colony)) {
+                    std::cerr << toggle.name << " switched on during a run with " << threads << " thread(s) failed" << std::endl;
+                    ++failures;
+                }
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Ch Oy @ NWPU
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// Converts a telemetry file into the CSV files the solver used to write:
+// BestPathLength.csv, AveragePathLength.csv and pheromones_<iteration>.csv.
+#include "../Telemetry.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: telemetry2csv <telemetry file> [output prefix]" << std::endl;
+        return 1;
+    }
+    std::string prefix = argc > 2 ? argv[2] : "";
+    TelemetryReader reader(argv[1]);
+    if (!reader.isValid()) {
+        std::cerr << "not a telemetry file: " << argv[1] << std::endl;
+        return 1;
+    }
+    const TelemetryHeader& header = reader.getHeader();
+    std::ofstream BPLfile(prefix + "BestPathLength.csv");
+    std::ofstream APLfile(prefix + "AveragePathLength.csv");
+    std::vector<float> values;
+    const std::vector<TelemetryIndexEntry>& index = reader.getIndex();
+    for (size_t i = 0; i < index.size(); ++i) {
+        if (index[i].type == IterationRecord) {
+            TelemetryIterationStats stats;
+            if (!reader.readIterationStats(index[i], stats)) continue;
+            BPLfile << stats.bestPathLength << "\n";
+            APLfile << stats.averagePathLength << "\n";
+        }
+        else if (index[i].type == SnapshotRecord && reader.readSnapshot(i, values)) {
+            std::ofstream file(prefix + "pheromones_" + std::to_string(index[i].iteration) + ".csv");
+            // one row per x column, as in the original [x][y] matrix layout
+            for (uint32_t x = 0; x < header.snapshotWidth; ++x) {
+                for (uint32_t y = 0; y < header.snapshotHeight; ++y) {
+                    file << values[(size_t)y * header.snapshotWidth + x];
+                    if (y < header.snapshotHeight - 1) file << ",";
+                }
+                file << "\n";
+            }
+        }
+    }
+    return 0;
+}